@@ -20,69 +20,144 @@
  * 
  */
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
-#include <fstream>
-#include <sstream>
 
 #include "Application.hpp"
 
+#include "Arguments.hpp"
+#include "ClutFile.hpp"
+#include "ClutMethod.hpp"
+#include "ClutMethods.hpp"
 #include "Image.hpp"
 #include "Exception.hpp"
-#include "PpmImageReader.hpp"
-#include "PpmImageWriter.hpp"
+#include "HardwareProbe.hpp"
+#include "ImageFormats.hpp"
 #include "TestBench.hpp"
 #include "Timer.hpp"
 
-#include "OriginalClutMethod.hpp"
-#include "OptimizedClutMethod.hpp"
-#include "IntegerClutMethod.hpp"
-#include "SseClutMethod.hpp"
+#include "ApplyBenchMode.hpp"
+#include "AsyncBenchMode.hpp"
+#include "BatchBenchMode.hpp"
+#include "ChainBenchMode.hpp"
+#include "GigapixelBenchMode.hpp"
+#include "HalfBenchMode.hpp"
+#include "HugePageBenchMode.hpp"
+#include "LatencyBenchMode.hpp"
+#include "LibraryBenchMode.hpp"
+#include "MultiBenchMode.hpp"
+#include "PackBenchMode.hpp"
+#include "PrefetchBenchMode.hpp"
+#include "PreviewBenchMode.hpp"
+#include "ProgressiveBenchMode.hpp"
+#include "SelectBenchMode.hpp"
+#include "ShaperBenchMode.hpp"
+#include "SortedBenchMode.hpp"
+#include "SweepBenchMode.hpp"
+#include "TilesBenchMode.hpp"
+#include "U16BenchMode.hpp"
 
 namespace
 {
 
-	std::vector<ClutMethod*> createClutMethods()
+	std::vector<BenchMode*> createBenchModes()
 	{
-		std::vector<ClutMethod*> clut_methods;
-		clut_methods.push_back(new OriginalClutMethod);
-		clut_methods.push_back(new OptimizedClutMethod);
-		clut_methods.push_back(new IntegerClutMethod);
-		clut_methods.push_back(new SseClutMethod);
-		return clut_methods;
+		std::vector<BenchMode*> bench_modes;
+		bench_modes.push_back(new SweepBenchMode);
+		bench_modes.push_back(new SortedBenchMode);
+		bench_modes.push_back(new PackBenchMode);
+		bench_modes.push_back(new ChainBenchMode);
+		bench_modes.push_back(new ShaperBenchMode);
+		bench_modes.push_back(new BatchBenchMode);
+		bench_modes.push_back(new MultiBenchMode);
+		bench_modes.push_back(new PreviewBenchMode);
+		bench_modes.push_back(new HugePageBenchMode);
+		bench_modes.push_back(new PrefetchBenchMode);
+		bench_modes.push_back(new GigapixelBenchMode);
+		bench_modes.push_back(new HalfBenchMode);
+		bench_modes.push_back(new U16BenchMode);
+		bench_modes.push_back(new TilesBenchMode);
+		bench_modes.push_back(new AsyncBenchMode);
+		bench_modes.push_back(new ProgressiveBenchMode);
+		bench_modes.push_back(new ApplyBenchMode);
+		bench_modes.push_back(new LibraryBenchMode);
+		bench_modes.push_back(new SelectBenchMode);
+		bench_modes.push_back(new LatencyBenchMode);
+		return bench_modes;
 	}
 
-	void destroyClutMethods(const std::vector<ClutMethod*>& clut_methods)
+	void destroyBenchModes(const std::vector<BenchMode*>& bench_modes)
 	{
-		for (std::vector<ClutMethod*>::const_iterator clut_methods_it = clut_methods.begin(); clut_methods_it != clut_methods.end(); ++clut_methods_it) {
-			delete *clut_methods_it;
+		for (std::vector<BenchMode*>::const_iterator bench_modes_it = bench_modes.begin(); bench_modes_it != bench_modes.end(); ++bench_modes_it) {
+			delete *bench_modes_it;
 		}
 	}
 
-	unsigned int getNumber(const std::string& string)
+	// Scaling to lattice coordinates (3 mul + 3 sub) and 7 lerps of 3 channels (2 mul + 1 add)
+	const double flops_per_pixel = 69.0;
+
+	double getBytesPerPixel(const ClutMethod* clut_method, unsigned int clut_level)
 	{
-		unsigned int res = 0;
-		std::istringstream(string) >> res;
-		return res;
+		const double clut_entries = std::pow(static_cast<double>(clut_level), 6);
+		// Input and output planes plus the 8 CLUT corners
+		return 2 * 3 * sizeof(float) + 8.0 * static_cast<double>(clut_method->getClutFootprint()) / clut_entries;
 	}
 
 	void runBenchmark(const std::vector<std::string>& args)
 	{
-		std::ifstream input_file(args[1].c_str());
 		Image input_image;
-		PpmImageReader().load(input_file, input_image);
-		std::ifstream clut_file(args[2].c_str());
+		Timer input_timer;
+		loadImage(args[1], input_image);
+		input_timer.stop();
+
+		// Outputs follow the input format, PPM unless it is PFM or PAM
+		std::string output_extension = getImageExtension(args[1]);
+		if (output_extension != ".pfm" && output_extension != ".pam") {
+			output_extension = ".ppm";
+		}
+
+		ClutFile clut_file;
 		Image clut_image;
-		PpmImageReader().load(clut_file, clut_image);
+		Timer load_timer;
+		if (ClutFile::isClutFile(args[2])) {
+			clut_file.load(args[2]);
+		} else {
+			loadImage(args[2], clut_image);
+		}
+		load_timer.stop();
 
 		unsigned int cycles = 10;
 		if (args.size() > 4) {
 			cycles = getNumber(args[4]);
 		}
 
+		float strength = 1.0f;
+		if (args.size() > 5) {
+			strength = getFloat(args[5]);
+		}
+
+		const HardwareLimits limits = getHardwareLimits();
+		const double bandwidth = limits.bandwidth;
+		const double peak_flops = limits.peak_flops;
+		std::cout << "Bandwidth:  " << bandwidth / 1.0e9 << " GB/s (STREAM triad" << (limits.measured ? "" : ", cached") << ")" << std::endl;
+		std::cout << "Peak:       " << peak_flops / 1.0e9 << " GFLOP/s (SSE, single thread" << (limits.measured ? "" : ", cached") << ")" << std::endl;
+		std::cout << "Input load: " << input_timer.getUSecs() << "us" << (input_image.hasAlpha() ? " (alpha passed through)" : "") << std::endl;
+		std::cout << "CLUT load:  " << load_timer.getUSecs() << "us" << std::endl;
+		std::cout << "Strength:   " << strength << std::endl;
+		std::cout << std::endl;
+
+		const double pixels = static_cast<double>(input_image.getWidth()) * input_image.getHeight() * cycles;
+
 		const std::vector<ClutMethod*> clut_methods = createClutMethods();
+		TestBench* test_bench = 0;
 
 		try {
-			TestBench test_bench(input_image, clut_image);
+			if (clut_file.isLoaded()) {
+				test_bench = new TestBench(input_image, clut_file);
+			} else {
+				test_bench = new TestBench(input_image, clut_image);
+			}
 			Image reference_image;
 			float reference_time_ms = 0.0f;
 
@@ -91,20 +166,66 @@ namespace
 					std::cout << std::endl;
 				}
 				ClutMethod* const clut_method = *clut_methods_it;
+				clut_method->setStrength(strength);
 
 				std::cout << "Method:     " << clut_method->getDescription() << std::endl;
-				const Timer timer = test_bench.run(clut_method, cycles);
+				Image::resetStatistics();
+				const Timer timer = test_bench->run(clut_method, cycles);
+				const Image::Statistics image_statistics = Image::getStatistics();
 				std::cout << "Time:       " << timer.getMSecs() << "ms" << std::endl;
+				std::cout << "Setup:      " << test_bench->getSetupTimer().getUSecs() << "us" << std::endl;
+
+				const double seconds = static_cast<double>(std::max(1ull, timer.getNSecs())) / 1.0e9;
+				const double bytes_per_pixel = getBytesPerPixel(clut_method, test_bench->getClutLevel());
+				const double bytes_per_second = pixels * bytes_per_pixel / seconds;
+				const double flops = pixels * flops_per_pixel / seconds;
+				const double intensity = flops_per_pixel / bytes_per_pixel;
+				std::cout
+					<< "Throughput: "
+					<< pixels / seconds / 1.0e6
+					<< " Mpix/s, "
+					<< bytes_per_pixel
+					<< " B/pixel, "
+					<< bytes_per_second / 1.0e9
+					<< " GB/s ("
+					<< 100.0 * bytes_per_second / bandwidth
+					<< "% of memory bandwidth)"
+					<< std::endl;
+				std::cout
+					<< "Roofline:   "
+					<< intensity
+					<< " FLOP/B, "
+					<< flops / 1.0e9
+					<< " GFLOP/s ("
+					<< 100.0 * flops / peak_flops
+					<< "% of peak), "
+					<< (intensity < peak_flops / bandwidth ? "memory-bound" : "compute-bound")
+					<< std::endl;
+
+				std::cout
+					<< "Images:     "
+					<< image_statistics.allocations
+					<< " plane chunk allocations ("
+					<< image_statistics.pooled
+					<< " more from the pool), "
+					<< (image_statistics.bytes_copied >> 10)
+					<< " KiB copied"
+					<< std::endl;
+
+				const std::string statistics = clut_method->getStatistics();
+				if (!statistics.empty()) {
+					std::cout << "Statistics: " << statistics << std::endl;
+				}
 
 				if (clut_methods_it == clut_methods.begin()) {
-					reference_image = test_bench.getOutputImage();
+					reference_image = test_bench->takeOutputImage();
 					reference_time_ms = timer.getMSecs();
 				} else {
 					const float speedup = reference_time_ms / static_cast<float>(std::max(1ull, timer.getMSecs()));
 					const float faster = 100.0f * reference_time_ms / static_cast<float>(std::max(1ull, timer.getMSecs())) - 100.0f;
 					std::cout << "Speedup:    " << speedup << " (" << faster << "% faster)" << std::endl;
 
-					const Image::Difference difference = reference_image.compare(test_bench.getOutputImage());
+					const Image::Difference difference = reference_image.compare(test_bench->getOutputImage());
 					std::cout
 						<< "Difference: "
 						<< difference.absolute
@@ -118,15 +239,19 @@ namespace
 						<< std::endl;
 				}
 
-				std::ofstream output_file((args[3] + '_' + clut_method->getFilename() + ".ppm").c_str());
-				PpmImageWriter().save(test_bench.getOutputImage(), output_file);
+				saveImage(
+					clut_methods_it == clut_methods.begin() ? reference_image : test_bench->getOutputImage(),
+					args[3] + '_' + clut_method->getFilename() + output_extension
+				);
 			}
 		}
 		catch (...) {
+			delete test_bench;
 			destroyClutMethods(clut_methods);
 			throw;
 		}
 
+		delete test_bench;
 		destroyClutMethods(clut_methods);
 	}
 
@@ -141,6 +266,7 @@ public:
 	int execute(const std::vector<std::string>& args);
 
 private:
+	const std::vector<BenchMode*> bench_modes;
 };
 
 Application::Application() :
@@ -158,23 +284,45 @@ int Application::execute(const std::vector<std::string>& args)
 	return implementation->execute(args);
 }
 
-Application::Implementation::Implementation()
+Application::Implementation::Implementation() :
+	bench_modes(createBenchModes())
 {
 }
 
 Application::Implementation::~Implementation()
 {
+	destroyBenchModes(bench_modes);
 }
 
 int Application::Implementation::execute(const std::vector<std::string>& args)
 {
-	if (args.size() < 4) {
-		std::cerr << "Usage:" << args[0] << " INPUT CLUT OUTPUT_PREFIX [CYCLES]" << std::endl;
+	BenchMode* bench_mode = 0;
+	if (args.size() > 1) {
+		for (std::vector<BenchMode*>::const_iterator bench_modes_it = bench_modes.begin(); bench_modes_it != bench_modes.end(); ++bench_modes_it) {
+			if (args[1] == (*bench_modes_it)->getName()) {
+				bench_mode = *bench_modes_it;
+			}
+		}
+	}
+
+	if (
+		bench_mode
+		? args.size() < 2 + bench_mode->getMinimumArgumentCount()
+		: args.size() < 4
+	) {
+		std::cerr << "Usage:" << args[0] << " INPUT CLUT OUTPUT_PREFIX [CYCLES] [STRENGTH]" << std::endl;
+		for (std::vector<BenchMode*>::const_iterator bench_modes_it = bench_modes.begin(); bench_modes_it != bench_modes.end(); ++bench_modes_it) {
+			std::cerr << "      " << args[0] << ' ' << (*bench_modes_it)->getName() << ' ' << (*bench_modes_it)->getUsage() << std::endl;
+		}
 		return 1;
 	}
 
 	try {
-		runBenchmark(args);
+		if (bench_mode) {
+			bench_mode->run(std::vector<std::string>(args.begin() + 2, args.end()));
+		} else {
+			runBenchmark(args);
+		}
 	}
 	catch (const Exception& exception)
 	{
@@ -0,0 +1,119 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "ApplyBenchMode.hpp"
+
+#include "clut.h"
+
+#include "Arguments.hpp"
+#include "Exception.hpp"
+#include "Image.hpp"
+#include "PpmImageReader.hpp"
+#include "PpmImageWriter.hpp"
+
+namespace
+{
+
+	std::vector<char> readFile(const std::string& path)
+	{
+		std::ifstream file(path.c_str(), std::ios::binary);
+		if (!file) {
+			throw Exception("Can't open " + path + '.', __FILE__, __LINE__);
+		}
+		return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+}
+
+const char* ApplyBenchMode::getName() const
+{
+	return "--apply";
+}
+
+const char* ApplyBenchMode::getUsage() const
+{
+	return "INPUT CLUT OUTPUT [KERNEL] [THREADS]";
+}
+
+unsigned int ApplyBenchMode::getMinimumArgumentCount() const
+{
+	return 3;
+}
+
+void ApplyBenchMode::run(const std::vector<std::string>& args)
+{
+	std::ifstream input_file(args[0].c_str());
+	Image image;
+	PpmImageReader(Image::PRECISION_U16).load(input_file, image);
+
+	const std::vector<char> clut_data = readFile(args[1]);
+
+	unsigned int threads = 1;
+	if (args.size() > 4) {
+		threads = getNumber(args[4]);
+	}
+
+	clut_t* clut;
+	clut_status status = clut_create_from_memory(clut_data.empty() ? 0 : &clut_data[0], clut_data.size(), &clut);
+	if (status != CLUT_OK) {
+		throw Exception(clut_get_status_message(status), __FILE__, __LINE__);
+	}
+
+	status = clut_set_kernel(clut, args.size() > 3 ? args[3].c_str() : clut_get_best_kernel(clut, CLUT_PIXEL_RGB16));
+	if (status == CLUT_OK && image.getWidth() && image.getHeight()) {
+		// Interleaved like a decoded frame in memory
+		const unsigned int width = image.getWidth();
+		std::vector<unsigned short> pixels(static_cast<size_t>(width) * image.getHeight() * 3);
+		for (unsigned int y = 0; y < image.getHeight(); ++y) {
+			for (unsigned int channel = 0; channel < 3; ++channel) {
+				const unsigned short* const row = static_cast<const unsigned short*>(image.getRow(channel, y));
+				for (unsigned int x = 0; x < width; ++x) {
+					pixels[(static_cast<size_t>(y) * width + x) * 3 + channel] = row[x];
+				}
+			}
+		}
+
+		const size_t stride = width * 3 * sizeof(unsigned short);
+		status = clut_apply(clut, &pixels[0], stride, &pixels[0], stride, width, image.getHeight(), CLUT_PIXEL_RGB16, threads);
+
+		for (unsigned int y = 0; y < image.getHeight(); ++y) {
+			for (unsigned int channel = 0; channel < 3; ++channel) {
+				unsigned short* const row = static_cast<unsigned short*>(image.getRow(channel, y));
+				for (unsigned int x = 0; x < width; ++x) {
+					row[x] = pixels[(static_cast<size_t>(y) * width + x) * 3 + channel];
+				}
+			}
+		}
+	}
+	clut_destroy(clut);
+
+	if (status != CLUT_OK) {
+		throw Exception(clut_get_status_message(status), __FILE__, __LINE__);
+	}
+
+	std::ofstream output_file(args[2].c_str());
+	PpmImageWriter().save(image, output_file);
+}
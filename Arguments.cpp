@@ -0,0 +1,71 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <sstream>
+
+#include "Arguments.hpp"
+
+#include "Exception.hpp"
+
+bool isNumber(const std::string& string)
+{
+	return !string.empty() && string.find_first_not_of("0123456789") == std::string::npos;
+}
+
+unsigned int getNumber(const std::string& string)
+{
+	unsigned int res = 0;
+	std::istringstream(string) >> res;
+	return res;
+}
+
+float getFloat(const std::string& string)
+{
+	float res = 0.0f;
+	std::istringstream(string) >> res;
+	return res;
+}
+
+std::vector<unsigned int> getNumberList(const std::string& string)
+{
+	std::vector<unsigned int> res;
+
+	std::istringstream stream(string);
+	std::string item;
+	while (std::getline(stream, item, ',')) {
+		const std::string::size_type dash = item.find('-');
+		if (dash == std::string::npos) {
+			res.push_back(getNumber(item));
+		} else {
+			const unsigned int first = getNumber(item.substr(0, dash));
+			const unsigned int last = getNumber(item.substr(dash + 1));
+			if (last < first) {
+				throw Exception("Malformed number range '" + item + "'.", __FILE__, __LINE__);
+			}
+			for (unsigned int number = first; number <= last; ++number) {
+				res.push_back(number);
+			}
+		}
+	}
+
+	return res;
+}
@@ -0,0 +1,169 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <iostream>
+
+#include <unistd.h>
+
+#include "AsyncBenchMode.hpp"
+
+#include "Arguments.hpp"
+#include "AsyncConverter.hpp"
+#include "Conversion.hpp"
+#include "Exception.hpp"
+#include "HaldClut.hpp"
+#include "Image.hpp"
+#include "ImageFormats.hpp"
+#include "SseClutMethod.hpp"
+#include "TestBench.hpp"
+#include "Timer.hpp"
+
+namespace
+{
+
+	const unsigned int cancel_trials = 10;
+
+	double getMSecsPerCycle(const Timer& timer, unsigned int cycles)
+	{
+		return static_cast<double>(timer.getUSecs()) / 1000.0 / cycles;
+	}
+
+}
+
+const char* AsyncBenchMode::getName() const
+{
+	return "--async";
+}
+
+const char* AsyncBenchMode::getUsage() const
+{
+	return "INPUT CLUT [CYCLES] [TILE_SIZE]";
+}
+
+unsigned int AsyncBenchMode::getMinimumArgumentCount() const
+{
+	return 2;
+}
+
+void AsyncBenchMode::run(const std::vector<std::string>& args)
+{
+	Image input_image;
+	loadImage(args[0], input_image);
+
+	Image clut_image;
+	loadImage(args[1], clut_image);
+
+	const unsigned int level = getHaldClutLevel(clut_image);
+	if (level < 2) {
+		throw Exception("CLUT image has wrong dimensions.", __FILE__, __LINE__);
+	}
+
+	unsigned int cycles = 10;
+	if (args.size() > 2) {
+		cycles = std::max(1u, getNumber(args[2]));
+	}
+
+	unsigned int tile_size = 64;
+	if (args.size() > 3) {
+		tile_size = getNumber(args[3]);
+	}
+
+	SseClutMethod clut_method;
+
+	TestBench test_bench(input_image, clut_image);
+	const Timer run_timer = test_bench.run(&clut_method, cycles);
+
+	Image rows_image;
+	Timer rows_timer;
+	for (unsigned int cycle = 0; cycle < cycles; ++cycle) {
+		convertRows(clut_method, input_image, rows_image);
+	}
+	rows_timer.stop();
+
+	AsyncConverter converter(ThreadPool::getDefaultThreadCount(), tile_size);
+
+	Image async_image;
+	Timer async_timer;
+	for (unsigned int cycle = 0; cycle < cycles; ++cycle) {
+		converter.submit(clut_method, input_image, async_image).wait();
+	}
+	async_timer.stop();
+
+	const Image::Difference difference = test_bench.getOutputImage().compare(async_image);
+
+	std::cout << "Threads:    " << converter.getThreadCount() << " (" << tile_size << " pixel tiles)" << std::endl;
+	std::cout << "Sync run:   " << getMSecsPerCycle(run_timer, cycles) << "ms (TestBench::run)" << std::endl;
+	std::cout << "Sync rows:  " << getMSecsPerCycle(rows_timer, cycles) << "ms (convertRows)" << std::endl;
+	std::cout << "Async:      " << getMSecsPerCycle(async_timer, cycles) << "ms" << std::endl;
+	std::cout
+		<< "Overhead:   "
+		<< (static_cast<double>(async_timer.getNSecs()) / std::max(1ull, run_timer.getNSecs()) - 1.0) * 100.0
+		<< "% vs run, "
+		<< (static_cast<double>(async_timer.getNSecs()) / std::max(1ull, rows_timer.getNSecs()) - 1.0) * 100.0
+		<< "% vs rows"
+		<< std::endl;
+	std::cout
+		<< "Difference: "
+		<< difference.absolute
+		<< " (Rmax "
+		<< difference.max_r
+		<< ", Gmax "
+		<< difference.max_g
+		<< ", Bmax "
+		<< difference.max_b
+		<< ')'
+		<< std::endl;
+
+	// Cancels at points spread over the conversion, like a slider moved again
+	const unsigned long long conversion_usecs = async_timer.getUSecs() / cycles;
+	unsigned long long total_cancel_usecs = 0;
+	unsigned long long max_cancel_usecs = 0;
+	double converted_fraction = 0.0;
+
+	for (unsigned int trial = 0; trial < cancel_trials; ++trial) {
+		AsyncConverter::Future future = converter.submit(clut_method, input_image, async_image);
+		usleep(conversion_usecs * trial / cancel_trials);
+
+		Timer cancel_timer;
+		future.cancel();
+		future.wait();
+		converter.wait();
+		cancel_timer.stop();
+
+		total_cancel_usecs += cancel_timer.getUSecs();
+		max_cancel_usecs = std::max(max_cancel_usecs, cancel_timer.getUSecs());
+		converted_fraction += static_cast<double>(future.getConvertedTileCount()) / std::max<size_t>(1, future.getTileCount());
+	}
+
+	std::cout
+		<< "Cancel:     "
+		<< total_cancel_usecs / cancel_trials
+		<< "us average, "
+		<< max_cancel_usecs
+		<< "us max to idle ("
+		<< cancel_trials
+		<< " trials, "
+		<< converted_fraction / cancel_trials * 100.0
+		<< "% of tiles converted on average)"
+		<< std::endl;
+}
@@ -0,0 +1,393 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+
+#include "AsyncConverter.hpp"
+
+#include "ClutMethod.hpp"
+#include "Conversion.hpp"
+#include "Exception.hpp"
+#include "Image.hpp"
+#include "Memory.hpp"
+
+namespace
+{
+
+	// Enough for many pending conversions, submit() should not block
+	const unsigned int max_queued_workers = 1024;
+
+}
+
+class AsyncConverter::Task
+{
+public:
+	Task(const ClutMethod& _clut_method, const Image& _input_image, Image& _output_image, unsigned int _x, unsigned int _y, unsigned int _width, unsigned int _height, unsigned int _tile_size, unsigned int _worker_count) :
+		clut_method(_clut_method),
+		input_image(_input_image),
+		output_image(_output_image),
+		x(_x),
+		y(_y),
+		width(_width),
+		height(_height),
+		tile_size(_tile_size),
+		tiles_x((_width + _tile_size - 1) / _tile_size),
+		tile_count(static_cast<size_t>(tiles_x) * ((_height + _tile_size - 1) / _tile_size)),
+		references(1),
+		workers(_worker_count),
+		next_tile(0),
+		converted_tiles(0),
+		cancelled(false)
+	{
+		pthread_mutex_init(&mutex, 0);
+		pthread_cond_init(&done, 0);
+	}
+
+	~Task()
+	{
+		pthread_cond_destroy(&done);
+		pthread_mutex_destroy(&mutex);
+	}
+
+	void addReference()
+	{
+		pthread_mutex_lock(&mutex);
+		++references;
+		pthread_mutex_unlock(&mutex);
+	}
+
+	void release()
+	{
+		pthread_mutex_lock(&mutex);
+		const bool last = --references == 0;
+		pthread_mutex_unlock(&mutex);
+		if (last) {
+			delete this;
+		}
+	}
+
+	// Returns false once all tiles are claimed or the task is cancelled
+	bool claimTile(size_t& tile)
+	{
+		pthread_mutex_lock(&mutex);
+		const bool claimed = !cancelled && next_tile < tile_count;
+		if (claimed) {
+			tile = next_tile;
+			++next_tile;
+		}
+		pthread_mutex_unlock(&mutex);
+		return claimed;
+	}
+
+	void finishTile()
+	{
+		pthread_mutex_lock(&mutex);
+		++converted_tiles;
+		pthread_mutex_unlock(&mutex);
+	}
+
+	// Also for workers that never got submitted
+	void finishWorkers(unsigned int count)
+	{
+		pthread_mutex_lock(&mutex);
+		workers -= count;
+		if (!workers) {
+			pthread_cond_broadcast(&done);
+		}
+		pthread_mutex_unlock(&mutex);
+	}
+
+	void convertTile(size_t tile, float* rgb) const
+	{
+		const unsigned int tile_x = x + (tile % tiles_x) * tile_size;
+		const unsigned int tile_y = y + (tile / tiles_x) * tile_size;
+		const unsigned int tile_width = std::min(tile_size, x + width - tile_x);
+		const unsigned int tile_height = std::min(tile_size, y + height - tile_y);
+
+		if (input_image.getPrecision() != Image::PRECISION_FLOAT || output_image.getPrecision() != Image::PRECISION_FLOAT) {
+			convertRegion(clut_method, input_image, output_image, tile_x, tile_y, tile_width, tile_height);
+			return;
+		}
+
+		for (unsigned int row = tile_y; row < tile_y + tile_height; ++row) {
+			loadFloatRow(
+				static_cast<const float*>(input_image.getRow(0, row)) + tile_x,
+				static_cast<const float*>(input_image.getRow(1, row)) + tile_x,
+				static_cast<const float*>(input_image.getRow(2, row)) + tile_x,
+				rgb,
+				tile_width
+			);
+			clut_method.convertRow(rgb, tile_width);
+			storeFloatRow(
+				rgb,
+				static_cast<float*>(output_image.getRow(0, row)) + tile_x,
+				static_cast<float*>(output_image.getRow(1, row)) + tile_x,
+				static_cast<float*>(output_image.getRow(2, row)) + tile_x,
+				tile_width
+			);
+		}
+	}
+
+	bool isDone()
+	{
+		pthread_mutex_lock(&mutex);
+		const bool res = !workers;
+		pthread_mutex_unlock(&mutex);
+		return res;
+	}
+
+	bool wait()
+	{
+		pthread_mutex_lock(&mutex);
+		while (workers) {
+			pthread_cond_wait(&done, &mutex);
+		}
+		const bool res = converted_tiles == tile_count;
+		pthread_mutex_unlock(&mutex);
+		return res;
+	}
+
+	void cancel()
+	{
+		pthread_mutex_lock(&mutex);
+		cancelled = true;
+		pthread_mutex_unlock(&mutex);
+	}
+
+	size_t getTileCount() const
+	{
+		return tile_count;
+	}
+
+	size_t getConvertedTileCount()
+	{
+		pthread_mutex_lock(&mutex);
+		const size_t res = converted_tiles;
+		pthread_mutex_unlock(&mutex);
+		return res;
+	}
+
+	unsigned int getTileSize() const
+	{
+		return tile_size;
+	}
+
+private:
+	Task(const Task& other);
+	Task& operator =(const Task& other);
+
+	const ClutMethod& clut_method;
+	const Image& input_image;
+	Image& output_image;
+	const unsigned int x;
+	const unsigned int y;
+	const unsigned int width;
+	const unsigned int height;
+	const unsigned int tile_size;
+	const unsigned int tiles_x;
+	const size_t tile_count;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t done;
+
+	unsigned int references;
+	unsigned int workers;
+	size_t next_tile;
+	size_t converted_tiles;
+	bool cancelled;
+};
+
+class AsyncConverter::Worker :
+	public ThreadPool::Job
+{
+public:
+	// Allocates up front, so run() can't fail before claiming tiles
+	explicit Worker(Task* _task) :
+		task(_task),
+		rgb(reinterpret_cast<float*>(allocateMemory(static_cast<size_t>(_task->getTileSize()) * 4 * sizeof(float), 4 * sizeof(float))))
+	{
+		task->addReference();
+	}
+
+	~Worker()
+	{
+		freeMemory(rgb);
+		task->release();
+	}
+
+	void run()
+	{
+		// A failing tile cancels the remaining ones, the worker is finished in any case
+		try {
+			size_t tile;
+			while (task->claimTile(tile)) {
+				task->convertTile(tile, rgb);
+				task->finishTile();
+			}
+		}
+		catch (...) {
+			task->cancel();
+		}
+
+		task->finishWorkers(1);
+	}
+
+private:
+	Task* const task;
+	float* const rgb;
+};
+
+AsyncConverter::Future::Future() :
+	task(0)
+{
+}
+
+AsyncConverter::Future::Future(const Future& other) :
+	task(other.task)
+{
+	if (task) {
+		task->addReference();
+	}
+}
+
+AsyncConverter::Future::~Future()
+{
+	if (task) {
+		task->release();
+	}
+}
+
+AsyncConverter::Future& AsyncConverter::Future::operator =(const Future& other)
+{
+	if (other.task) {
+		other.task->addReference();
+	}
+	if (task) {
+		task->release();
+	}
+	task = other.task;
+	return *this;
+}
+
+bool AsyncConverter::Future::isValid() const
+{
+	return task != 0;
+}
+
+bool AsyncConverter::Future::isDone() const
+{
+	return !task || task->isDone();
+}
+
+bool AsyncConverter::Future::wait() const
+{
+	return task && task->wait();
+}
+
+void AsyncConverter::Future::cancel()
+{
+	if (task) {
+		task->cancel();
+	}
+}
+
+size_t AsyncConverter::Future::getTileCount() const
+{
+	return task ? task->getTileCount() : 0;
+}
+
+size_t AsyncConverter::Future::getConvertedTileCount() const
+{
+	return task ? task->getConvertedTileCount() : 0;
+}
+
+AsyncConverter::Future::Future(Task* _task) :
+	task(_task)
+{
+}
+
+AsyncConverter::AsyncConverter(unsigned int thread_count, unsigned int _tile_size) :
+	tile_size(_tile_size),
+	thread_pool(thread_count, max_queued_workers)
+{
+	if (tile_size < 4) {
+		throw Exception("Tile size must be at least 4.", __FILE__, __LINE__);
+	}
+}
+
+AsyncConverter::~AsyncConverter()
+{
+	thread_pool.wait();
+}
+
+AsyncConverter::Future AsyncConverter::submit(const ClutMethod& clut_method, const Image& input_image, Image& output_image, unsigned int x, unsigned int y, unsigned int width, unsigned int height)
+{
+	x = std::min(x, input_image.getWidth());
+	y = std::min(y, input_image.getHeight());
+	width = std::min(width, input_image.getWidth() - x);
+	height = std::min(height, input_image.getHeight() - y);
+
+	const unsigned int tile_count = ((width + tile_size - 1) / tile_size) * ((height + tile_size - 1) / tile_size);
+	const unsigned int worker_count = std::min(thread_pool.getThreadCount(), tile_count);
+
+	// The future holds the first reference
+	Task* const task = new Task(clut_method, input_image, output_image, x, y, width, height, tile_size, worker_count);
+	const Future future(task);
+
+	unsigned int submitted = 0;
+	try {
+		for (; submitted < worker_count; ++submitted) {
+			thread_pool.submit(new Worker(task));
+		}
+	}
+	catch (...) {
+		// The submitted workers still convert every tile, without any the task never finishes
+		task->finishWorkers(worker_count - submitted);
+		if (!submitted) {
+			throw;
+		}
+	}
+
+	return future;
+}
+
+AsyncConverter::Future AsyncConverter::submit(const ClutMethod& clut_method, const Image& input_image, Image& output_image)
+{
+	output_image.clearAndInitialize(input_image.getWidth(), input_image.getHeight(), false);
+	output_image.copyAlpha(input_image);
+	return submit(clut_method, input_image, output_image, 0, 0, input_image.getWidth(), input_image.getHeight());
+}
+
+void AsyncConverter::wait()
+{
+	thread_pool.wait();
+}
+
+unsigned int AsyncConverter::getThreadCount() const
+{
+	return thread_pool.getThreadCount();
+}
+
+unsigned int AsyncConverter::getTileSize() const
+{
+	return tile_size;
+}
@@ -0,0 +1,97 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "ThreadPool.hpp"
+
+class ClutMethod;
+class Image;
+
+// Asynchronous front end for interactive clients: a submitted conversion is
+// split into square tiles, which the workers of a shared pool claim one by
+// one. Cancellation is checked before each tile, so a cancelled conversion
+// stops after the tiles already running. The method must tolerate
+// concurrent convertRow() calls, and input, output and method must outlive
+// the conversion.
+class AsyncConverter
+{
+private:
+	class Task;
+
+public:
+	// Handle to a submitted conversion, copies refer to the same one
+	class Future
+	{
+	public:
+		Future();
+		Future(const Future& other);
+		~Future();
+
+		Future& operator =(const Future& other);
+
+		bool isValid() const;
+		bool isDone() const;
+		// Returns true if all tiles were converted, false if cancelled
+		bool wait() const;
+		// Tiles already running are finished, the others skipped
+		void cancel();
+
+		size_t getTileCount() const;
+		size_t getConvertedTileCount() const;
+
+	private:
+		friend class AsyncConverter;
+
+		explicit Future(Task* _task);
+
+		Task* task;
+	};
+
+	explicit AsyncConverter(unsigned int thread_count = ThreadPool::getDefaultThreadCount(), unsigned int _tile_size = 64);
+	// Waits for everything still running
+	~AsyncConverter();
+
+	// Converts a region of the input into the same region of the output,
+	// which must be big enough (see convertRegion())
+	Future submit(const ClutMethod& clut_method, const Image& input_image, Image& output_image, unsigned int x, unsigned int y, unsigned int width, unsigned int height);
+	// Converts the whole input, (re)initializing the output right away
+	Future submit(const ClutMethod& clut_method, const Image& input_image, Image& output_image);
+
+	// Returns when the pool is idle
+	void wait();
+
+	unsigned int getThreadCount() const;
+	unsigned int getTileSize() const;
+
+private:
+	class Worker;
+
+	AsyncConverter(const AsyncConverter& other);
+	AsyncConverter& operator =(const AsyncConverter& other);
+
+	const unsigned int tile_size;
+
+	ThreadPool thread_pool;
+};
@@ -0,0 +1,268 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "BatchBenchMode.hpp"
+
+#include "Conversion.hpp"
+#include "Exception.hpp"
+#include "HaldClut.hpp"
+#include "Image.hpp"
+#include "PpmImageReader.hpp"
+#include "PpmImageWriter.hpp"
+#include "SseClutMethod.hpp"
+#include "ThreadPool.hpp"
+#include "Timer.hpp"
+
+namespace
+{
+
+	class Statistics
+	{
+	public:
+		Statistics() :
+			images(0),
+			failures(0),
+			setup_nsecs(0),
+			convert_nsecs(0),
+			save_nsecs(0)
+		{
+			pthread_mutex_init(&mutex, 0);
+		}
+
+		~Statistics()
+		{
+			pthread_mutex_destroy(&mutex);
+		}
+
+		void add(unsigned long long _setup_nsecs, unsigned long long _convert_nsecs, unsigned long long _save_nsecs)
+		{
+			pthread_mutex_lock(&mutex);
+			++images;
+			setup_nsecs += _setup_nsecs;
+			convert_nsecs += _convert_nsecs;
+			save_nsecs += _save_nsecs;
+			pthread_mutex_unlock(&mutex);
+		}
+
+		void addFailure(const std::string& path, const std::string& what)
+		{
+			pthread_mutex_lock(&mutex);
+			++failures;
+			std::cerr << path << ": " << what << std::endl;
+			pthread_mutex_unlock(&mutex);
+		}
+
+		unsigned int images;
+		unsigned int failures;
+		unsigned long long setup_nsecs;
+		unsigned long long convert_nsecs;
+		unsigned long long save_nsecs;
+
+	private:
+		pthread_mutex_t mutex;
+	};
+
+	class BatchJob :
+		public ThreadPool::Job
+	{
+	public:
+		BatchJob(const ClutMethod& _clut_method, const std::string& _input_path, const std::string& _output_path, Statistics& _statistics) :
+			clut_method(_clut_method),
+			input_path(_input_path),
+			output_path(_output_path),
+			statistics(_statistics)
+		{
+		}
+
+		void run()
+		{
+			try {
+				Timer setup_timer;
+				std::ifstream input_file(input_path.c_str());
+				Image input_image;
+				PpmImageReader().load(input_file, input_image);
+				Image output_image;
+				output_image.clearAndInitialize(input_image.getWidth(), input_image.getHeight(), false);
+				setup_timer.stop();
+
+				Timer convert_timer;
+				convertRegion(clut_method, input_image, output_image, 0, 0, input_image.getWidth(), input_image.getHeight());
+				convert_timer.stop();
+
+				Timer save_timer;
+				std::ofstream output_file(output_path.c_str());
+				PpmImageWriter().save(output_image, output_file);
+				save_timer.stop();
+
+				statistics.add(setup_timer.getNSecs(), convert_timer.getNSecs(), save_timer.getNSecs());
+			}
+			// Also std::bad_alloc and the like, run() must not throw
+			catch (const std::exception& exception) {
+				statistics.addFailure(input_path, exception.what());
+			}
+			catch (...) {
+				statistics.addFailure(input_path, "Unknown error.");
+			}
+		}
+
+	private:
+		const ClutMethod& clut_method;
+		const std::string input_path;
+		const std::string output_path;
+		Statistics& statistics;
+	};
+
+	bool isDirectory(const std::string& path)
+	{
+		struct stat path_stat;
+		return !stat(path.c_str(), &path_stat) && S_ISDIR(path_stat.st_mode);
+	}
+
+	bool hasPpmSuffix(const std::string& name)
+	{
+		return name.size() > 4 && name.compare(name.size() - 4, 4, ".ppm") == 0;
+	}
+
+	std::string getBasename(const std::string& path)
+	{
+		const std::string::size_type slash = path.rfind('/');
+		return slash == std::string::npos ? path : path.substr(slash + 1);
+	}
+
+	void addInputPaths(const std::string& path, std::vector<std::string>& input_paths)
+	{
+		if (!isDirectory(path)) {
+			input_paths.push_back(path);
+			return;
+		}
+
+		DIR* const directory = opendir(path.c_str());
+		if (!directory) {
+			throw Exception("Can't read directory '" + path + "'.", __FILE__, __LINE__);
+		}
+
+		std::vector<std::string> names;
+		while (const dirent* const entry = readdir(directory)) {
+			if (hasPpmSuffix(entry->d_name)) {
+				names.push_back(entry->d_name);
+			}
+		}
+		closedir(directory);
+
+		std::sort(names.begin(), names.end());
+		for (std::vector<std::string>::const_iterator names_it = names.begin(); names_it != names.end(); ++names_it) {
+			input_paths.push_back(path + '/' + *names_it);
+		}
+	}
+
+	double getShare(unsigned long long part, unsigned long long total)
+	{
+		return total ? 100.0 * static_cast<double>(part) / static_cast<double>(total) : 0.0;
+	}
+
+}
+
+const char* BatchBenchMode::getName() const
+{
+	return "--batch";
+}
+
+const char* BatchBenchMode::getUsage() const
+{
+	return "CLUT OUTPUT_DIRECTORY INPUT|DIRECTORY...";
+}
+
+unsigned int BatchBenchMode::getMinimumArgumentCount() const
+{
+	return 3;
+}
+
+void BatchBenchMode::run(const std::vector<std::string>& args)
+{
+	Timer total_timer;
+
+	std::vector<std::string> input_paths;
+	for (std::vector<std::string>::const_iterator args_it = args.begin() + 2; args_it != args.end(); ++args_it) {
+		addInputPaths(*args_it, input_paths);
+	}
+
+	Timer clut_timer;
+	std::ifstream clut_file(args[0].c_str());
+	Image clut_image;
+	PpmImageReader().load(clut_file, clut_image);
+	const unsigned int level = getHaldClutLevel(clut_image);
+	if (level < 2) {
+		throw Exception("CLUT image has wrong dimensions.", __FILE__, __LINE__);
+	}
+
+	// Shared by all workers, convert() doesn't modify it
+	SseClutMethod clut_method;
+	clut_method.setClut(clut_image, level);
+	clut_timer.stop();
+
+	Statistics statistics;
+	unsigned int thread_count = 0;
+
+	{
+		// At most two images per thread are in flight: One running, one queued
+		ThreadPool thread_pool(ThreadPool::getDefaultThreadCount(), ThreadPool::getDefaultThreadCount());
+		thread_count = thread_pool.getThreadCount();
+
+		for (std::vector<std::string>::const_iterator input_paths_it = input_paths.begin(); input_paths_it != input_paths.end(); ++input_paths_it) {
+			thread_pool.submit(new BatchJob(clut_method, *input_paths_it, args[1] + '/' + getBasename(*input_paths_it), statistics));
+		}
+
+		thread_pool.wait();
+	}
+
+	total_timer.stop();
+
+	const unsigned long long worker_nsecs = statistics.setup_nsecs + statistics.convert_nsecs + statistics.save_nsecs;
+
+	std::cout << "Images:     " << statistics.images << " (" << statistics.failures << " failed)" << std::endl;
+	std::cout << "Threads:    " << thread_count << std::endl;
+	std::cout << "CLUT setup: " << clut_timer.getMSecs() << "ms once (" << getShare(clut_timer.getNSecs(), total_timer.getNSecs()) << "% of total)" << std::endl;
+	std::cout
+		<< "Total:      "
+		<< total_timer.getMSecs()
+		<< "ms ("
+		<< static_cast<double>(statistics.images) * 1.0e9 / static_cast<double>(std::max(1ull, total_timer.getNSecs()))
+		<< " images/s)"
+		<< std::endl;
+	std::cout
+		<< "Workers:    "
+		<< getShare(statistics.setup_nsecs, worker_nsecs)
+		<< "% per-image setup, "
+		<< getShare(statistics.convert_nsecs, worker_nsecs)
+		<< "% convert, "
+		<< getShare(statistics.save_nsecs, worker_nsecs)
+		<< "% save"
+		<< std::endl;
+}
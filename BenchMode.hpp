@@ -0,0 +1,40 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+
+class BenchMode
+{
+public:
+	virtual ~BenchMode()
+	{
+	}
+
+	virtual const char* getName() const = 0;
+	virtual const char* getUsage() const = 0;
+	virtual unsigned int getMinimumArgumentCount() const = 0;
+
+	virtual void run(const std::vector<std::string>& args) = 0;
+};
@@ -0,0 +1,78 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#include <sys/stat.h>
+
+#include "CacheFiles.hpp"
+
+#include "Exception.hpp"
+
+namespace
+{
+
+	void createDirectories(const std::string& path)
+	{
+		for (std::string::size_type slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+			if (mkdir(path.substr(0, slash).c_str(), 0755) && errno != EEXIST) {
+				throw Exception("Could not create directory for " + path + ".", __FILE__, __LINE__);
+			}
+		}
+	}
+
+}
+
+std::string getCachePath(const std::string& name)
+{
+	const char* const cache_home = std::getenv("XDG_CACHE_HOME");
+	if (cache_home && *cache_home) {
+		return std::string(cache_home) + "/clutbench/" + name;
+	}
+
+	const char* const home = std::getenv("HOME");
+	return std::string(home && *home ? home : ".") + "/.cache/clutbench/" + name;
+}
+
+void writeCacheFile(const std::string& path, const std::string& contents)
+{
+	createDirectories(path);
+
+	const std::string temporary_path = path + ".tmp";
+	{
+		std::ofstream file(temporary_path.c_str());
+		file << contents;
+		file.close();
+		if (file.fail()) {
+			std::remove(temporary_path.c_str());
+			throw Exception("Could not write " + temporary_path + ".", __FILE__, __LINE__);
+		}
+	}
+
+	if (std::rename(temporary_path.c_str(), path.c_str())) {
+		std::remove(temporary_path.c_str());
+		throw Exception("Could not replace " + path + ".", __FILE__, __LINE__);
+	}
+}
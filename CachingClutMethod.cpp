@@ -0,0 +1,144 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <sstream>
+
+#include <xmmintrin.h>
+
+#include "CachingClutMethod.hpp"
+
+#include "Memory.hpp"
+
+namespace
+{
+
+	// 1024 entries of 32B fit into the L1 cache
+	const unsigned int cache_bits = 10;
+	const unsigned int cache_size = 1 << cache_bits;
+
+	// Set in every valid key, so a zeroed entry never matches
+	const unsigned long long valid_flag = 1ull << 48;
+
+	inline unsigned long long getKey(const float* rgb)
+	{
+		return
+			static_cast<unsigned long long>(rgb[0])
+			| static_cast<unsigned long long>(rgb[1]) << 16
+			| static_cast<unsigned long long>(rgb[2]) << 32
+			| valid_flag;
+	}
+
+	inline unsigned int getSlot(unsigned long long key)
+	{
+		return (key * 0x9E3779B97F4A7C15ull) >> (64 - cache_bits);
+	}
+
+}
+
+CachingClutMethod::CachingClutMethod() :
+	cache(reinterpret_cast<CacheEntry*>(allocateMemory(cache_size * sizeof(CacheEntry), sizeof(CacheEntry)))),
+	lookups(0),
+	hits(0)
+{
+	resetCache();
+}
+
+CachingClutMethod::~CachingClutMethod()
+{
+	freeMemory(cache);
+}
+
+const char* CachingClutMethod::getDescription() const
+{
+	return "Integer clut storage with SSE and direct-mapped result cache";
+}
+
+const char* CachingClutMethod::getFilename() const
+{
+	return "cached";
+}
+
+void CachingClutMethod::setClut(const Image& image, unsigned int level)
+{
+	SseClutMethod::setClut(image, level);
+	resetCache();
+}
+
+bool CachingClutMethod::setPackedClut(const unsigned short* packed_clut, unsigned int level)
+{
+	SseClutMethod::setPackedClut(packed_clut, level);
+	resetCache();
+	return true;
+}
+
+void CachingClutMethod::convert(float* rgb) const
+{
+	const unsigned long long key = getKey(rgb);
+	CacheEntry& entry = cache[getSlot(key)];
+
+	++lookups;
+	if (entry.key == key) {
+		++hits;
+		_mm_store_ps(rgb, _mm_load_ps(entry.rgb));
+		return;
+	}
+
+	SseClutMethod::convert(rgb);
+
+	_mm_store_ps(entry.rgb, _mm_load_ps(rgb));
+	entry.key = key;
+}
+
+void CachingClutMethod::setStrength(float _strength)
+{
+	SseClutMethod::setStrength(_strength);
+	resetCache();
+}
+
+std::string CachingClutMethod::getStatistics() const
+{
+	std::ostringstream res;
+	res
+		<< "Hit rate "
+		<< (lookups ? 100.0 * static_cast<double>(hits) / static_cast<double>(lookups) : 0.0)
+		<< "% ("
+		<< hits
+		<< " of "
+		<< lookups
+		<< " lookups in a "
+		<< cache_size * sizeof(CacheEntry) / 1024
+		<< " KiB result cache)";
+	return res.str();
+}
+
+bool CachingClutMethod::locateCell(const float* rgb, ClutCell& cell) const
+{
+	return false;
+}
+
+void CachingClutMethod::resetCache()
+{
+	std::fill(reinterpret_cast<char*>(cache), reinterpret_cast<char*>(cache + cache_size), 0);
+	lookups = 0;
+	hits = 0;
+}
@@ -0,0 +1,60 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#pragma once
+
+#include "SseClutMethod.hpp"
+
+// The SSE method with a direct-mapped result cache in front of it. The cache
+// is updated by convert(), so instances must not be shared between threads.
+class CachingClutMethod :
+	public SseClutMethod
+{
+public:
+	CachingClutMethod();
+	~CachingClutMethod();
+
+	const char* getDescription() const;
+	const char* getFilename() const;
+
+	void setClut(const Image& image, unsigned int level);
+	bool setPackedClut(const unsigned short* packed_clut, unsigned int level);
+	void convert(float* rgb) const;
+	void setStrength(float _strength);
+
+	std::string getStatistics() const;
+
+	// The cache lookup is not split into phases
+	bool locateCell(const float* rgb, ClutCell& cell) const;
+
+private:
+	struct CacheEntry {
+		float rgb[4];
+		unsigned long long key;
+	} __attribute__((aligned(32)));
+
+	void resetCache();
+
+	CacheEntry* const cache;
+	mutable unsigned long long lookups;
+	mutable unsigned long long hits;
+};
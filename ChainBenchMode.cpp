@@ -0,0 +1,152 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+
+#include "ChainBenchMode.hpp"
+
+#include "Arguments.hpp"
+#include "HaldClut.hpp"
+#include "Image.hpp"
+#include "PpmImageReader.hpp"
+#include "SseClutMethod.hpp"
+#include "TestBench.hpp"
+#include "Timer.hpp"
+
+namespace
+{
+
+	void destroyImages(const std::vector<const Image*>& images)
+	{
+		for (std::vector<const Image*>::const_iterator images_it = images.begin(); images_it != images.end(); ++images_it) {
+			delete *images_it;
+		}
+	}
+
+	void destroyTestBenches(const std::vector<TestBench*>& test_benches)
+	{
+		for (std::vector<TestBench*>::const_iterator test_benches_it = test_benches.begin(); test_benches_it != test_benches.end(); ++test_benches_it) {
+			delete *test_benches_it;
+		}
+	}
+
+}
+
+const char* ChainBenchMode::getName() const
+{
+	return "--chain";
+}
+
+const char* ChainBenchMode::getUsage() const
+{
+	return "INPUT CLUT CLUT [CLUT...] [CYCLES]";
+}
+
+unsigned int ChainBenchMode::getMinimumArgumentCount() const
+{
+	return 3;
+}
+
+void ChainBenchMode::run(const std::vector<std::string>& args)
+{
+	std::ifstream input_file(args[0].c_str());
+	Image input_image;
+	PpmImageReader().load(input_file, input_image);
+
+	// A trailing number is no CLUT
+	std::vector<std::string>::const_iterator clut_args_end = args.end();
+	unsigned int cycles = 3;
+	if (args.size() > 3 && isNumber(args.back())) {
+		--clut_args_end;
+		cycles = std::max(1u, getNumber(args.back()));
+	}
+
+	std::vector<const Image*> clut_images;
+	std::vector<TestBench*> test_benches;
+
+	try {
+		for (std::vector<std::string>::const_iterator args_it = args.begin() + 1; args_it != clut_args_end; ++args_it) {
+			std::ifstream clut_file(args_it->c_str());
+			Image* const clut_image = new Image;
+			clut_images.push_back(clut_image);
+			PpmImageReader().load(clut_file, *clut_image);
+		}
+
+		SseClutMethod clut_method;
+
+		// Chained: Each CLUT is a full pass over the output of the previous one
+		unsigned long long chained_nsecs = 0;
+		for (std::vector<const Image*>::const_iterator clut_images_it = clut_images.begin(); clut_images_it != clut_images.end(); ++clut_images_it) {
+			test_benches.push_back(
+				new TestBench(
+					test_benches.empty()
+						? input_image
+						: test_benches.back()->getOutputImage(),
+					**clut_images_it
+				)
+			);
+			chained_nsecs += test_benches.back()->run(&clut_method, 1).getNSecs();
+		}
+		// The first cycle above produced the inputs, now time the remaining ones
+		for (unsigned int cycle = 1; cycle < cycles; ++cycle) {
+			for (std::vector<TestBench*>::const_iterator test_benches_it = test_benches.begin(); test_benches_it != test_benches.end(); ++test_benches_it) {
+				chained_nsecs += (*test_benches_it)->run(&clut_method, 1).getNSecs();
+			}
+		}
+
+		Timer compose_timer;
+		Image composed_clut_image;
+		composeHaldCluts(clut_images, composed_clut_image);
+		compose_timer.stop();
+
+		TestBench composed_test_bench(input_image, composed_clut_image);
+		const unsigned long long composed_nsecs = composed_test_bench.run(&clut_method, cycles).getNSecs();
+
+		const Image::Difference difference = test_benches.back()->getOutputImage().compare(composed_test_bench.getOutputImage());
+
+		std::cout << "CLUTs:      " << clut_images.size() << std::endl;
+		std::cout << "Chained:    " << chained_nsecs / cycles / 1000000 << "ms" << std::endl;
+		std::cout << "Composed:   " << composed_nsecs / cycles / 1000000 << "ms (plus " << compose_timer.getMSecs() << "ms once for composing)" << std::endl;
+		std::cout << "Speedup:    " << static_cast<float>(chained_nsecs) / static_cast<float>(std::max(1ull, composed_nsecs)) << std::endl;
+		std::cout
+			<< "Difference: "
+			<< difference.absolute
+			<< " (Rmax "
+			<< difference.max_r
+			<< ", Gmax "
+			<< difference.max_g
+			<< ", Bmax "
+			<< difference.max_b
+			<< ')'
+			<< std::endl;
+	}
+	catch (...) {
+		destroyTestBenches(test_benches);
+		destroyImages(clut_images);
+		throw;
+	}
+
+	destroyTestBenches(test_benches);
+	destroyImages(clut_images);
+}
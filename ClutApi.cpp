@@ -0,0 +1,702 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <istream>
+#include <new>
+#include <streambuf>
+#include <vector>
+
+#include "clut.h"
+
+#include "ClutMethod.hpp"
+#include "Exception.hpp"
+#include "FixedPointClutMethod.hpp"
+#include "HaldClut.hpp"
+#include "Image.hpp"
+#include "ImageFormats.hpp"
+#include "IntegerClutMethod.hpp"
+#include "KernelSelection.hpp"
+#include "Memory.hpp"
+#include "NearestClutMethod.hpp"
+#include "OptimizedClutMethod.hpp"
+#include "OriginalClutMethod.hpp"
+#include "PrefetchClutMethod.hpp"
+#include "SseClutMethod.hpp"
+#include "ThreadPool.hpp"
+#include "Timer.hpp"
+
+namespace
+{
+
+	struct Kernel {
+		const char* name;
+		ClutMethod* (*create)();
+		// Converts 16b pixels without a float round trip
+		bool native_16b;
+	};
+
+	template<class T>
+	ClutMethod* createKernel()
+	{
+		return new T;
+	}
+
+	// The caching method updates its cache while converting and the shaper
+	// needs curves, so neither is offered here
+	const Kernel kernels[] = {
+		{"original", createKernel<OriginalClutMethod>, false},
+		{"optimized", createKernel<OptimizedClutMethod>, false},
+		{"integer", createKernel<IntegerClutMethod>, false},
+		{"sse", createKernel<SseClutMethod>, false},
+		{"prefetch", createKernel<PrefetchClutMethod>, false},
+		{"nearest", createKernel<NearestClutMethod>, false},
+		{"fixed", createKernel<FixedPointClutMethod>, true}
+	};
+
+	const unsigned int kernel_count = sizeof(kernels) / sizeof(kernels[0]);
+
+	// Used until a kernel is chosen, it is the best one for floats on most machines
+	const char* const default_kernel = "sse";
+
+	const unsigned int format_count = CLUT_PIXEL_RGBA32F + 1;
+
+	const Kernel* findKernel(const char* name)
+	{
+		for (unsigned int index = 0; index < kernel_count; ++index) {
+			if (!std::strcmp(kernels[index].name, name)) {
+				return kernels + index;
+			}
+		}
+		return 0;
+	}
+
+	// Bands per thread, so uneven rows even out
+	const unsigned int bands_per_thread = 4;
+	const unsigned int min_band_height = 16;
+
+	class MemoryStreamBuffer :
+		public std::streambuf
+	{
+	public:
+		MemoryStreamBuffer(const void* data, size_t size)
+		{
+			char* const begin = const_cast<char*>(static_cast<const char*>(data));
+			setg(begin, begin, begin + size);
+		}
+	};
+
+	bool isValidFormat(clut_pixel_format format)
+	{
+		return format >= CLUT_PIXEL_RGB8 && format <= CLUT_PIXEL_RGBA32F;
+	}
+
+	unsigned int getChannelCount(clut_pixel_format format)
+	{
+		return format == CLUT_PIXEL_RGBA8 || format == CLUT_PIXEL_RGBA16 || format == CLUT_PIXEL_RGBA32F ? 4 : 3;
+	}
+
+	unsigned int getSampleSize(clut_pixel_format format)
+	{
+		switch (format) {
+			case CLUT_PIXEL_RGB8:
+			case CLUT_PIXEL_RGBA8: {
+				return 1;
+			}
+
+			case CLUT_PIXEL_RGB16:
+			case CLUT_PIXEL_RGBA16: {
+				return 2;
+			}
+
+			default: {
+				return 4;
+			}
+		}
+	}
+
+	float loadSample(const char* row, unsigned int index, clut_pixel_format format)
+	{
+		switch (getSampleSize(format)) {
+			case 1: {
+				return static_cast<float>(reinterpret_cast<const unsigned char*>(row)[index]) * 257.0f;
+			}
+
+			case 2: {
+				return reinterpret_cast<const unsigned short*>(row)[index];
+			}
+
+			default: {
+				return reinterpret_cast<const float*>(row)[index] * 65535.0f;
+			}
+		}
+	}
+
+	// Truncating like PpmImageWriter, 8b rounded
+	void storeSample(float value, char* row, unsigned int index, clut_pixel_format format)
+	{
+		value = std::max(0.0f, std::min(65535.0f, value));
+		switch (getSampleSize(format)) {
+			case 1: {
+				reinterpret_cast<unsigned char*>(row)[index] = value / 257.0f + 0.5f;
+				break;
+			}
+
+			case 2: {
+				reinterpret_cast<unsigned short*>(row)[index] = value;
+				break;
+			}
+
+			default: {
+				reinterpret_cast<float*>(row)[index] = value / 65535.0f;
+				break;
+			}
+		}
+	}
+
+	void copyAlpha(const char* source, char* destination, unsigned int width, clut_pixel_format format)
+	{
+		if (getChannelCount(format) == 4 && source != destination) {
+			const unsigned int sample_size = getSampleSize(format);
+			for (unsigned int x = 0; x < width; ++x) {
+				std::memcpy(destination + (x * 4 + 3) * sample_size, source + (x * 4 + 3) * sample_size, sample_size);
+			}
+		}
+	}
+
+	// Four float or 16b samples per pixel for convertRow() or convertRow16()
+	void convertRow(const ClutMethod& clut_method, bool native_16b, const char* source, char* destination, unsigned int width, clut_pixel_format format, void* buffer)
+	{
+		const unsigned int channels = getChannelCount(format);
+
+		if (native_16b && getSampleSize(format) != 4) {
+			unsigned short* const rgb = static_cast<unsigned short*>(buffer);
+			for (unsigned int x = 0; x < width; ++x) {
+				for (unsigned int channel = 0; channel < 3; ++channel) {
+					rgb[x * 4 + channel] = loadSample(source, x * channels + channel, format);
+				}
+				rgb[x * 4 + 3] = 0;
+			}
+			clut_method.convertRow16(rgb, width);
+			copyAlpha(source, destination, width, format);
+			for (unsigned int x = 0; x < width; ++x) {
+				for (unsigned int channel = 0; channel < 3; ++channel) {
+					storeSample(rgb[x * 4 + channel], destination, x * channels + channel, format);
+				}
+			}
+			return;
+		}
+
+		float* const rgb = static_cast<float*>(buffer);
+		for (unsigned int x = 0; x < width; ++x) {
+			for (unsigned int channel = 0; channel < 3; ++channel) {
+				rgb[x * 4 + channel] = loadSample(source, x * channels + channel, format);
+			}
+			rgb[x * 4 + 3] = 0.0f;
+		}
+		clut_method.convertRow(rgb, width);
+		copyAlpha(source, destination, width, format);
+		for (unsigned int x = 0; x < width; ++x) {
+			for (unsigned int channel = 0; channel < 3; ++channel) {
+				storeSample(rgb[x * 4 + channel], destination, x * channels + channel, format);
+			}
+		}
+	}
+
+	const char* getFormatName(clut_pixel_format format)
+	{
+		static const char* const names[format_count] = {"RGB8", "RGBA8", "RGB16", "RGBA16", "RGB32F", "RGBA32F"};
+		return names[format];
+	}
+
+	// Largest difference to the original kernel, in 16b steps, that is not
+	// measurable in the format: half an 8b step, the 16b rounding of the
+	// fixed point kernel and float rounding
+	unsigned int getTolerance(clut_pixel_format format)
+	{
+		switch (getSampleSize(format)) {
+			case 1: {
+				return 128;
+			}
+
+			case 2: {
+				return 2;
+			}
+
+			default: {
+				return 1;
+			}
+		}
+	}
+
+	struct Rows {
+		const ClutMethod* clut_method;
+		bool native_16b;
+		const char* source;
+		size_t source_stride;
+		char* destination;
+		size_t destination_stride;
+		unsigned int width;
+		clut_pixel_format format;
+	};
+
+	void* allocateRowBuffer(unsigned int width)
+	{
+		return allocateMemory(static_cast<size_t>(width) * 4 * sizeof(float), 4 * sizeof(float));
+	}
+
+	void convertBand(const Rows& rows, unsigned int first_row, unsigned int end_row, void* buffer)
+	{
+		for (unsigned int y = first_row; y < end_row; ++y) {
+			convertRow(
+				*rows.clut_method,
+				rows.native_16b,
+				rows.source + y * rows.source_stride,
+				rows.destination + y * rows.destination_stride,
+				rows.width,
+				rows.format,
+				buffer
+			);
+		}
+	}
+
+	class BandJob :
+		public ThreadPool::Job
+	{
+	public:
+		// The buffer is allocated up front, so running can't fail
+		BandJob(const Rows& _rows, unsigned int _first_row, unsigned int _end_row, void* _buffer) :
+			rows(_rows),
+			first_row(_first_row),
+			end_row(_end_row),
+			buffer(_buffer)
+		{
+		}
+
+		void run()
+		{
+			convertBand(rows, first_row, end_row, buffer);
+		}
+
+	private:
+		const Rows rows;
+		const unsigned int first_row;
+		const unsigned int end_row;
+		void* const buffer;
+	};
+
+	clut_status getStatus(bool loading)
+	{
+		try {
+			throw;
+		}
+		catch (const std::bad_alloc&) {
+			return CLUT_ERROR_MEMORY;
+		}
+		catch (const Exception&) {
+			return loading ? CLUT_ERROR_FORMAT : CLUT_ERROR_INTERNAL;
+		}
+		catch (...) {
+			return CLUT_ERROR_INTERNAL;
+		}
+	}
+
+}
+
+struct clut {
+	Image clut_image;
+	unsigned int level;
+	float strength;
+	const Kernel* kernel;
+	ClutMethod* clut_method;
+	ThreadPool* thread_pool;
+	// Per format, filled by clut_get_best_kernel()
+	const Kernel* best_kernels[format_count];
+};
+
+namespace
+{
+
+	// Times every kernel on random pixels of the format through the row
+	// conversion of clut_apply() and returns the fastest one within the
+	// tolerance against the original kernel
+	const Kernel* measureBestKernel(const clut_t* clut, clut_pixel_format format)
+	{
+		const unsigned int width = 256;
+		const unsigned int height = 64;
+		const unsigned int cycles = 3;
+
+		const unsigned int channels = getChannelCount(format);
+		const size_t stride = static_cast<size_t>(width) * channels * getSampleSize(format);
+		const size_t samples = static_cast<size_t>(width) * height * channels;
+
+		std::vector<char> source(stride * height);
+		std::vector<char> reference(stride * height);
+		std::vector<char> destination(stride * height);
+
+		unsigned int seed = 1;
+		for (size_t index = 0; index < samples; ++index) {
+			seed = seed * 1103515245 + 12345;
+			storeSample((seed >> 8) & 0xFFFF, &source[0], index, format);
+		}
+
+		const Kernel* best_kernel = 0;
+		unsigned long long best_nsecs = 0;
+
+		void* const buffer = allocateRowBuffer(width);
+		ClutMethod* clut_method = 0;
+
+		try {
+			for (unsigned int index = 0; index < kernel_count; ++index) {
+				clut_method = kernels[index].create();
+				clut_method->setClut(clut->clut_image, clut->level);
+
+				const Rows rows = {clut_method, kernels[index].native_16b, &source[0], stride, index ? &destination[0] : &reference[0], stride, width, format};
+
+				unsigned long long nsecs = 0;
+				for (unsigned int cycle = 0; cycle < cycles; ++cycle) {
+					Timer timer;
+					convertBand(rows, 0, height, buffer);
+					timer.stop();
+					if (!cycle || timer.getNSecs() < nsecs) {
+						nsecs = timer.getNSecs();
+					}
+				}
+
+				delete clut_method;
+				clut_method = 0;
+
+				float max_error = 0.0f;
+				if (index) {
+					for (size_t sample = 0; sample < samples; ++sample) {
+						max_error = std::max(max_error, std::fabs(loadSample(&destination[0], sample, format) - loadSample(&reference[0], sample, format)));
+					}
+				}
+
+				if (max_error <= getTolerance(format) && (!best_kernel || nsecs < best_nsecs)) {
+					best_kernel = kernels + index;
+					best_nsecs = nsecs;
+				}
+			}
+		}
+		catch (...) {
+			delete clut_method;
+			freeMemory(buffer);
+			throw;
+		}
+
+		freeMemory(buffer);
+		return best_kernel;
+	}
+
+	clut_status createClut(Image& clut_image, clut_t** res)
+	{
+		const unsigned int level = getHaldClutLevel(clut_image);
+		if (level < 2) {
+			return CLUT_ERROR_FORMAT;
+		}
+
+		clut_t* const new_clut = new clut;
+		new_clut->level = level;
+		new_clut->strength = 1.0f;
+		new_clut->kernel = 0;
+		new_clut->clut_method = 0;
+		new_clut->thread_pool = 0;
+		std::fill(new_clut->best_kernels, new_clut->best_kernels + format_count, static_cast<const Kernel*>(0));
+		new_clut->clut_image = std::move(clut_image);
+
+		const clut_status status = clut_set_kernel(new_clut, default_kernel);
+		if (status != CLUT_OK) {
+			clut_destroy(new_clut);
+			return status;
+		}
+
+		*res = new_clut;
+		return CLUT_OK;
+	}
+
+}
+
+clut_status clut_create_from_memory(const void* data, size_t size, clut_t** res)
+{
+	if (!data || !res) {
+		return CLUT_ERROR_ARGUMENT;
+	}
+
+	try {
+		MemoryStreamBuffer buffer(data, size);
+		std::istream stream(&buffer);
+		Image clut_image;
+		loadImage(stream, clut_image);
+		return createClut(clut_image, res);
+	}
+	catch (...) {
+		return getStatus(true);
+	}
+}
+
+clut_status clut_create_from_pixels(const void* pixels, unsigned int width, unsigned int height, size_t stride, clut_pixel_format format, clut_t** res)
+{
+	if (!pixels || !res || !isValidFormat(format)) {
+		return CLUT_ERROR_ARGUMENT;
+	}
+
+	try {
+		Image clut_image;
+		clut_image.clearAndInitialize(width, height, false);
+
+		const unsigned int channels = getChannelCount(format);
+		for (unsigned int y = 0; y < height; ++y) {
+			const char* const row = static_cast<const char*>(pixels) + y * stride;
+			for (unsigned int x = 0; x < width; ++x) {
+				clut_image.setR(x, y, loadSample(row, x * channels, format));
+				clut_image.setG(x, y, loadSample(row, x * channels + 1, format));
+				clut_image.setB(x, y, loadSample(row, x * channels + 2, format));
+			}
+		}
+
+		return createClut(clut_image, res);
+	}
+	catch (...) {
+		return getStatus(true);
+	}
+}
+
+void clut_destroy(clut_t* clut)
+{
+	if (clut) {
+		delete clut->thread_pool;
+		delete clut->clut_method;
+		delete clut;
+	}
+}
+
+unsigned int clut_get_level(const clut_t* clut)
+{
+	return clut ? clut->level : 0;
+}
+
+unsigned int clut_get_kernel_count(void)
+{
+	return kernel_count;
+}
+
+const char* clut_get_kernel_name(unsigned int index)
+{
+	return index < kernel_count ? kernels[index].name : 0;
+}
+
+const char* clut_get_best_kernel(const clut_t* clut, clut_pixel_format format)
+{
+	if (!clut || !isValidFormat(format)) {
+		return 0;
+	}
+
+	const Kernel*& best_kernel = const_cast<clut_t*>(clut)->best_kernels[format];
+	if (best_kernel) {
+		return best_kernel->name;
+	}
+
+	try {
+		KernelChoices kernel_choices(KernelChoices::getDefaultPath());
+		const std::string machine = KernelChoices::getMachine() + ", clut_apply " + getFormatName(format);
+
+		std::string name;
+		if (kernel_choices.find(machine, clut->level, getTolerance(format), name) && findKernel(name.c_str())) {
+			best_kernel = findKernel(name.c_str());
+			return best_kernel->name;
+		}
+
+		best_kernel = measureBestKernel(clut, format);
+
+		try {
+			kernel_choices.set(machine, clut->level, getTolerance(format), best_kernel->name);
+			kernel_choices.save();
+		}
+		catch (const Exception&) {
+			// Only a cache, the choice is still kept in the handle
+		}
+
+		return best_kernel->name;
+	}
+	catch (...) {
+		return 0;
+	}
+}
+
+const char* clut_get_kernel(const clut_t* clut)
+{
+	return clut && clut->kernel ? clut->kernel->name : 0;
+}
+
+clut_status clut_set_kernel(clut_t* clut, const char* name)
+{
+	if (!clut) {
+		return CLUT_ERROR_ARGUMENT;
+	}
+
+	if (!name) {
+		name = clut_get_best_kernel(clut, CLUT_PIXEL_RGB32F);
+		if (!name) {
+			return CLUT_ERROR_INTERNAL;
+		}
+	}
+
+	const Kernel* const kernel = findKernel(name);
+	if (!kernel) {
+		return CLUT_ERROR_ARGUMENT;
+	}
+
+	try {
+		ClutMethod* const clut_method = kernel->create();
+		try {
+			clut_method->setClut(clut->clut_image, clut->level);
+			clut_method->setStrength(clut->strength);
+		}
+		catch (...) {
+			delete clut_method;
+			throw;
+		}
+
+		delete clut->clut_method;
+		clut->clut_method = clut_method;
+		clut->kernel = kernel;
+		return CLUT_OK;
+	}
+	catch (...) {
+		return getStatus(false);
+	}
+}
+
+clut_status clut_set_strength(clut_t* clut, float strength)
+{
+	if (!clut) {
+		return CLUT_ERROR_ARGUMENT;
+	}
+
+	clut->strength = strength;
+	clut->clut_method->setStrength(strength);
+	return CLUT_OK;
+}
+
+clut_status clut_apply(clut_t* clut, const void* source, size_t source_stride, void* destination, size_t destination_stride, unsigned int width, unsigned int height, clut_pixel_format format, unsigned int threads)
+{
+	if (!clut || !source || !destination || !isValidFormat(format)) {
+		return CLUT_ERROR_ARGUMENT;
+	}
+
+	const size_t row_size = static_cast<size_t>(width) * getChannelCount(format) * getSampleSize(format);
+	if (height > 1 && (source_stride < row_size || destination_stride < row_size)) {
+		return CLUT_ERROR_ARGUMENT;
+	}
+
+	const Rows rows = {
+		clut->clut_method,
+		clut->kernel->native_16b,
+		static_cast<const char*>(source),
+		source_stride,
+		static_cast<char*>(destination),
+		destination_stride,
+		width,
+		format
+	};
+
+	try {
+		if (!threads) {
+			threads = ThreadPool::getDefaultThreadCount();
+		}
+		threads = std::min(threads, std::max(1u, height / min_band_height));
+
+		if (threads < 2) {
+			void* const buffer = allocateRowBuffer(width);
+			convertBand(rows, 0, height, buffer);
+			freeMemory(buffer);
+			return CLUT_OK;
+		}
+
+		if (!clut->thread_pool || clut->thread_pool->getThreadCount() != threads) {
+			delete clut->thread_pool;
+			clut->thread_pool = 0;
+			clut->thread_pool = new ThreadPool(threads, threads * bands_per_thread);
+		}
+
+		const unsigned int bands = threads * bands_per_thread;
+		std::vector<void*> buffers;
+		try {
+			for (unsigned int band = 0; band < bands; ++band) {
+				buffers.push_back(allocateRowBuffer(width));
+			}
+		}
+		catch (...) {
+			std::for_each(buffers.begin(), buffers.end(), freeMemory);
+			throw;
+		}
+
+		try {
+			for (unsigned int band = 0; band < bands; ++band) {
+				const unsigned int first_row = static_cast<unsigned long long>(height) * band / bands;
+				const unsigned int end_row = static_cast<unsigned long long>(height) * (band + 1) / bands;
+				clut->thread_pool->submit(new BandJob(rows, first_row, end_row, buffers[band]));
+			}
+		}
+		catch (...) {
+			clut->thread_pool->wait();
+			std::for_each(buffers.begin(), buffers.end(), freeMemory);
+			throw;
+		}
+		clut->thread_pool->wait();
+
+		std::for_each(buffers.begin(), buffers.end(), freeMemory);
+
+		return CLUT_OK;
+	}
+	catch (...) {
+		return getStatus(false);
+	}
+}
+
+const char* clut_get_status_message(clut_status status)
+{
+	switch (status) {
+		case CLUT_OK: {
+			return "No error";
+		}
+
+		case CLUT_ERROR_ARGUMENT: {
+			return "Invalid argument";
+		}
+
+		case CLUT_ERROR_FORMAT: {
+			return "Malformed or unsupported CLUT";
+		}
+
+		case CLUT_ERROR_MEMORY: {
+			return "Out of memory";
+		}
+
+		default: {
+			return "Internal error";
+		}
+	}
+}
@@ -0,0 +1,255 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ClutFile.hpp"
+
+#include "Exception.hpp"
+#include "HaldClut.hpp"
+#include "Image.hpp"
+
+namespace
+{
+
+	const char magic[8] = {'C', 'L', 'U', 'T', 'B', 'I', 'N', '\0'};
+	const unsigned int version = 1;
+
+	// The kernels index the level^6 lattice entries with 32 bit unsigned ints,
+	// 41^6 exceeds that
+	const unsigned int max_level = 40;
+
+	enum {
+		FORMAT_U16X4 = 1 // R, G, B and one padding component, 16b each
+	};
+
+	enum {
+		LAYOUT_HALD = 1 // HaldCLUT order, red varying fastest
+	};
+
+	// 64 bytes, so the data following it stays cache line aligned
+	struct Header {
+		char magic[8];
+		unsigned int version;
+		unsigned int level;
+		unsigned int format;
+		unsigned int layout;
+		unsigned long long entry_count;
+		unsigned long long checksum;
+		char reserved[24];
+	};
+
+	unsigned long long getEntryCount(unsigned int level)
+	{
+		const unsigned long long size = static_cast<unsigned long long>(level) * level * level;
+		return size * size;
+	}
+
+	// Fletcher-64 over 32b words
+	unsigned long long getChecksum(const unsigned short* data, unsigned long long entry_count)
+	{
+		const unsigned int* const words = reinterpret_cast<const unsigned int*>(data);
+		const unsigned long long word_count = entry_count * 2;
+
+		unsigned long long sum1 = 0;
+		unsigned long long sum2 = 0;
+		for (unsigned long long word = 0; word < word_count; ++word) {
+			sum1 += words[word];
+			sum2 += sum1;
+			if (!(word & 0xFFF)) {
+				sum1 %= 0xFFFFFFFFull;
+				sum2 %= 0xFFFFFFFFull;
+			}
+		}
+		sum1 %= 0xFFFFFFFFull;
+		sum2 %= 0xFFFFFFFFull;
+
+		return sum2 << 32 | sum1;
+	}
+
+}
+
+ClutFile::ClutFile() :
+	mapping(0),
+	mapping_size(0),
+	level(0),
+	data(0),
+	checksum(0)
+{
+}
+
+ClutFile::~ClutFile()
+{
+	unload();
+}
+
+bool ClutFile::isClutFile(const std::string& path)
+{
+	std::ifstream file(path.c_str(), std::ios::binary);
+	char file_magic[sizeof(magic)];
+	return
+		file.read(file_magic, sizeof(file_magic))
+		&& std::equal(magic, magic + sizeof(magic), file_magic);
+}
+
+void ClutFile::save(const Image& clut_image, const std::string& path)
+{
+	const unsigned int level = getHaldClutLevel(clut_image);
+	if (level < 2) {
+		throw Exception("CLUT image has wrong dimensions.", __FILE__, __LINE__);
+	}
+
+	Header header;
+	std::memset(&header, 0, sizeof(header));
+	std::copy(magic, magic + sizeof(magic), header.magic);
+	header.version = version;
+	header.level = level;
+	header.format = FORMAT_U16X4;
+	header.layout = LAYOUT_HALD;
+	header.entry_count = getEntryCount(level);
+
+	std::vector<unsigned short> packed(header.entry_count * 4, 0);
+	size_t index = 0;
+	for (unsigned int y = 0; y < clut_image.getHeight(); ++y) {
+		for (unsigned int x = 0; x < clut_image.getWidth(); ++x) {
+			packed[index] = clut_image.getR(x, y);
+			++index;
+			packed[index] = clut_image.getG(x, y);
+			++index;
+			packed[index] = clut_image.getB(x, y);
+			index += 2;
+		}
+	}
+
+	header.checksum = getChecksum(&packed[0], header.entry_count);
+
+	std::ofstream file(path.c_str(), std::ios::binary);
+	if (
+		!file.write(reinterpret_cast<const char*>(&header), sizeof(header))
+		|| !file.write(reinterpret_cast<const char*>(&packed[0]), packed.size() * sizeof(unsigned short))
+	) {
+		throw Exception("Can't write CLUT file.", __FILE__, __LINE__);
+	}
+}
+
+void ClutFile::load(const std::string& path)
+{
+	unload();
+
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw Exception("Can't open CLUT file.", __FILE__, __LINE__);
+	}
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) || static_cast<size_t>(file_stat.st_size) < sizeof(Header)) {
+		close(fd);
+		throw Exception("Malformed CLUT file.", __FILE__, __LINE__);
+	}
+
+	void* const new_mapping = mmap(0, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (new_mapping == MAP_FAILED) {
+		throw Exception("Can't map CLUT file.", __FILE__, __LINE__);
+	}
+
+	mapping = new_mapping;
+	mapping_size = file_stat.st_size;
+
+	const Header& header = *reinterpret_cast<const Header*>(mapping);
+	const unsigned short* const new_data = reinterpret_cast<const unsigned short*>(&header + 1);
+
+	if (
+		!std::equal(magic, magic + sizeof(magic), header.magic)
+		|| header.version != version
+		|| header.format != FORMAT_U16X4
+		|| header.layout != LAYOUT_HALD
+		|| header.level < 2
+		|| header.level > max_level
+		|| header.entry_count != getEntryCount(header.level)
+		|| (mapping_size - sizeof(Header)) / (4 * sizeof(unsigned short)) < header.entry_count
+	) {
+		unload();
+		throw Exception("Malformed CLUT file.", __FILE__, __LINE__);
+	}
+
+	level = header.level;
+	data = new_data;
+	checksum = header.checksum;
+}
+
+bool ClutFile::isLoaded() const
+{
+	return data;
+}
+
+bool ClutFile::verify() const
+{
+	return data && getChecksum(data, getEntryCount(level)) == checksum;
+}
+
+unsigned int ClutFile::getLevel() const
+{
+	return level;
+}
+
+const unsigned short* ClutFile::getData() const
+{
+	return data;
+}
+
+void ClutFile::unpack(Image& image) const
+{
+	const unsigned int size = level * level * level;
+
+	image.clearAndInitialize(size, size, false);
+
+	size_t index = 0;
+	for (unsigned int y = 0; y < size; ++y) {
+		for (unsigned int x = 0; x < size; ++x) {
+			image.setR(x, y, data[index]);
+			image.setG(x, y, data[index + 1]);
+			image.setB(x, y, data[index + 2]);
+			index += 4;
+		}
+	}
+}
+
+void ClutFile::unload()
+{
+	if (mapping) {
+		munmap(mapping, mapping_size);
+	}
+	mapping = 0;
+	mapping_size = 0;
+	level = 0;
+	data = 0;
+	checksum = 0;
+}
@@ -0,0 +1,65 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+class Image;
+
+// Binary CLUT container holding the 4 * 16b interleaved storage of the
+// integer methods, so it can be mapped read-only instead of being parsed
+// and repacked. The mapped pages are shared between processes.
+class ClutFile
+{
+public:
+	ClutFile();
+	~ClutFile();
+
+	static bool isClutFile(const std::string& path);
+	static void save(const Image& clut_image, const std::string& path);
+
+	// Only validates the header, so the data pages are faulted in on use
+	void load(const std::string& path);
+	bool isLoaded() const;
+	// Compares the checksum over the whole data, touching every page
+	bool verify() const;
+
+	unsigned int getLevel() const;
+	const unsigned short* getData() const;
+
+	void unpack(Image& image) const;
+
+private:
+	ClutFile(const ClutFile& other);
+	ClutFile& operator =(const ClutFile& other);
+
+	void unload();
+
+	void* mapping;
+	size_t mapping_size;
+
+	unsigned int level;
+	const unsigned short* data;
+	unsigned long long checksum;
+};
@@ -22,8 +22,18 @@
 
 #pragma once
 
+#include <cstddef>
+#include <string>
+
 class Image;
 
+// Lower corner of the CLUT cell holding a pixel and the pixel's position
+// inside it, the first phase of convert()
+struct ClutCell {
+	float fraction[4] __attribute__((aligned(16)));
+	unsigned int color;
+};
+
 class ClutMethod
 {
 public:
@@ -35,5 +45,58 @@ public:
 	virtual const char* getFilename() const = 0;
 
 	virtual void setClut(const Image& image, unsigned int level) = 0;
+
+	// Uses already packed 4 * 16b storage (see ClutFile) without copying,
+	// returns false if the method has its own storage format
+	virtual bool setPackedClut(const unsigned short* packed_clut, unsigned int level)
+	{
+		return false;
+	}
 	virtual void convert(float* rgb) const = 0;
+
+	// Converts count aligned four float pixels in place, so kernels can look ahead
+	virtual void convertRow(float* rgb, size_t count) const
+	{
+		for (size_t pixel = 0; pixel < count; ++pixel) {
+			convert(rgb + pixel * 4);
+		}
+	}
+
+	// Converts count four 16b sample pixels in place, by default through convert()
+	virtual void convertRow16(unsigned short* rgb, size_t count) const
+	{
+		for (size_t pixel = 0; pixel < count; ++pixel) {
+			float value[4] __attribute__((aligned(16)));
+			value[0] = rgb[pixel * 4];
+			value[1] = rgb[pixel * 4 + 1];
+			value[2] = rgb[pixel * 4 + 2];
+			value[3] = 0.0f;
+			convert(value);
+			for (unsigned int channel = 0; channel < 3; ++channel) {
+				rgb[pixel * 4 + channel] = value[channel] < 0.0f ? 0 : value[channel] > 65535.0f ? 65535 : static_cast<unsigned short>(value[channel]);
+			}
+		}
+	}
+
+	// Blends the result with the input: out = in + strength * (lut - in)
+	virtual void setStrength(float strength) = 0;
+
+	virtual size_t getClutFootprint() const = 0;
+
+	// Method specific figures gathered during conversion, empty if there are none
+	virtual std::string getStatistics() const
+	{
+		return std::string();
+	}
+
+	// The two phases of convert(), so they can be timed on their own:
+	// locating the cell, returning false if the method does not split its
+	// phases, and interpolating between the cell's corners, in place
+	virtual bool locateCell(const float* rgb, ClutCell& cell) const
+	{
+		return false;
+	}
+	virtual void interpolateCell(const ClutCell& cell, float* rgb) const
+	{
+	}
 };
@@ -0,0 +1,61 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include "ClutMethods.hpp"
+
+#include "OriginalClutMethod.hpp"
+#include "OptimizedClutMethod.hpp"
+#include "IntegerClutMethod.hpp"
+#include "SseClutMethod.hpp"
+#include "CachingClutMethod.hpp"
+#include "NearestClutMethod.hpp"
+#include "PrefetchClutMethod.hpp"
+#include "FixedPointClutMethod.hpp"
+#include "ShaperClutMethod.hpp"
+
+std::vector<ClutMethod*> createClutMethods()
+{
+	std::vector<ClutMethod*> clut_methods;
+	clut_methods.push_back(new OriginalClutMethod);
+	clut_methods.push_back(new OptimizedClutMethod);
+	clut_methods.push_back(new IntegerClutMethod);
+	clut_methods.push_back(new SseClutMethod);
+	clut_methods.push_back(new CachingClutMethod);
+	return clut_methods;
+}
+
+std::vector<ClutMethod*> createAllClutMethods()
+{
+	std::vector<ClutMethod*> clut_methods = createClutMethods();
+	clut_methods.push_back(new NearestClutMethod);
+	clut_methods.push_back(new PrefetchClutMethod);
+	clut_methods.push_back(new FixedPointClutMethod);
+	clut_methods.push_back(new ShaperClutMethod);
+	return clut_methods;
+}
+
+void destroyClutMethods(const std::vector<ClutMethod*>& clut_methods)
+{
+	for (std::vector<ClutMethod*>::const_iterator clut_methods_it = clut_methods.begin(); clut_methods_it != clut_methods.end(); ++clut_methods_it) {
+		delete *clut_methods_it;
+	}
+}
@@ -0,0 +1,339 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include <xmmintrin.h>
+
+#include "Conversion.hpp"
+
+#include "ClutMethod.hpp"
+#include "HalfFloat.hpp"
+#include "Image.hpp"
+#include "Memory.hpp"
+
+void loadFloatRow(const float* red, const float* green, const float* blue, float* rgb, size_t count)
+{
+	size_t pixel = 0;
+	for (; pixel + 4 <= count; pixel += 4) {
+		__m128 v_r = _mm_loadu_ps(red + pixel);
+		__m128 v_g = _mm_loadu_ps(green + pixel);
+		__m128 v_b = _mm_loadu_ps(blue + pixel);
+		__m128 v_zero = _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS(v_r, v_g, v_b, v_zero);
+		_mm_store_ps(rgb + pixel * 4, v_r);
+		_mm_store_ps(rgb + pixel * 4 + 4, v_g);
+		_mm_store_ps(rgb + pixel * 4 + 8, v_b);
+		_mm_store_ps(rgb + pixel * 4 + 12, v_zero);
+	}
+	for (; pixel < count; ++pixel) {
+		rgb[pixel * 4] = red[pixel];
+		rgb[pixel * 4 + 1] = green[pixel];
+		rgb[pixel * 4 + 2] = blue[pixel];
+		rgb[pixel * 4 + 3] = 0.0f;
+	}
+}
+
+void storeFloatRow(const float* rgb, float* red, float* green, float* blue, size_t count)
+{
+	const __m128 v_min = _mm_setzero_ps();
+	const __m128 v_max = _mm_set_ps1(65535.0f);
+
+	size_t pixel = 0;
+	for (; pixel + 4 <= count; pixel += 4) {
+		__m128 v_r = _mm_load_ps(rgb + pixel * 4);
+		__m128 v_g = _mm_load_ps(rgb + pixel * 4 + 4);
+		__m128 v_b = _mm_load_ps(rgb + pixel * 4 + 8);
+		__m128 v_x = _mm_load_ps(rgb + pixel * 4 + 12);
+		_MM_TRANSPOSE4_PS(v_r, v_g, v_b, v_x);
+		_mm_storeu_ps(red + pixel, _mm_min_ps(v_max, _mm_max_ps(v_min, v_r)));
+		_mm_storeu_ps(green + pixel, _mm_min_ps(v_max, _mm_max_ps(v_min, v_g)));
+		_mm_storeu_ps(blue + pixel, _mm_min_ps(v_max, _mm_max_ps(v_min, v_b)));
+	}
+	for (; pixel < count; ++pixel) {
+		red[pixel] = std::max(0.0f, std::min(65535.0f, rgb[pixel * 4]));
+		green[pixel] = std::max(0.0f, std::min(65535.0f, rgb[pixel * 4 + 1]));
+		blue[pixel] = std::max(0.0f, std::min(65535.0f, rgb[pixel * 4 + 2]));
+	}
+}
+
+void convertRegion(const ClutMethod& clut_method, const Image& input_image, Image& output_image, unsigned int x, unsigned int y, unsigned int width, unsigned int height)
+{
+	const unsigned int end_x = std::min(input_image.getWidth(), x + width);
+	const unsigned int end_y = std::min(input_image.getHeight(), y + height);
+
+	for (unsigned int row = y; row < end_y; ++row) {
+		for (unsigned int column = x; column < end_x; ++column) {
+			float rgb[4] __attribute__((aligned(16)));
+			rgb[0] = input_image.getR(column, row);
+			rgb[1] = input_image.getG(column, row);
+			rgb[2] = input_image.getB(column, row);
+			rgb[3] = 0.0f;
+			clut_method.convert(rgb);
+			output_image.setR(column, row, rgb[0]);
+			output_image.setG(column, row, rgb[1]);
+			output_image.setB(column, row, rgb[2]);
+		}
+	}
+}
+
+void convertImage(const ClutMethod& clut_method, const Image& input_image, Image& output_image)
+{
+	output_image.clearAndInitialize(input_image.getWidth(), input_image.getHeight(), false);
+	output_image.copyAlpha(input_image);
+	convertRegion(clut_method, input_image, output_image, 0, 0, input_image.getWidth(), input_image.getHeight());
+}
+
+void convertRows(const ClutMethod& clut_method, const Image& input_image, Image& output_image)
+{
+	const unsigned int width = input_image.getWidth();
+	output_image.clearAndInitialize(width, input_image.getHeight(), false, input_image.getPrecision());
+	output_image.copyAlpha(input_image);
+
+	float* const rgb = reinterpret_cast<float*>(allocateMemory(static_cast<size_t>(width) * 4 * sizeof(float), 4 * sizeof(float)));
+	unsigned short* const rgb16 = reinterpret_cast<unsigned short*>(rgb);
+
+	for (unsigned int y = 0; y < input_image.getHeight(); ++y) {
+		switch (input_image.getPrecision()) {
+			case Image::PRECISION_FLOAT: {
+				loadFloatRow(
+					static_cast<const float*>(input_image.getRow(0, y)),
+					static_cast<const float*>(input_image.getRow(1, y)),
+					static_cast<const float*>(input_image.getRow(2, y)),
+					rgb,
+					width
+				);
+				clut_method.convertRow(rgb, width);
+				storeFloatRow(
+					rgb,
+					static_cast<float*>(output_image.getRow(0, y)),
+					static_cast<float*>(output_image.getRow(1, y)),
+					static_cast<float*>(output_image.getRow(2, y)),
+					width
+				);
+				break;
+			}
+
+			case Image::PRECISION_HALF: {
+				loadHalfRow(
+					static_cast<const unsigned short*>(input_image.getRow(0, y)),
+					static_cast<const unsigned short*>(input_image.getRow(1, y)),
+					static_cast<const unsigned short*>(input_image.getRow(2, y)),
+					rgb,
+					width
+				);
+				clut_method.convertRow(rgb, width);
+				storeHalfRow(
+					rgb,
+					static_cast<unsigned short*>(output_image.getRow(0, y)),
+					static_cast<unsigned short*>(output_image.getRow(1, y)),
+					static_cast<unsigned short*>(output_image.getRow(2, y)),
+					width
+				);
+				break;
+			}
+
+			case Image::PRECISION_U16: {
+				// The samples stay integers all the way through
+				const unsigned short* const red = static_cast<const unsigned short*>(input_image.getRow(0, y));
+				const unsigned short* const green = static_cast<const unsigned short*>(input_image.getRow(1, y));
+				const unsigned short* const blue = static_cast<const unsigned short*>(input_image.getRow(2, y));
+				for (unsigned int x = 0; x < width; ++x) {
+					rgb16[x * 4] = red[x];
+					rgb16[x * 4 + 1] = green[x];
+					rgb16[x * 4 + 2] = blue[x];
+					rgb16[x * 4 + 3] = 0;
+				}
+				clut_method.convertRow16(rgb16, width);
+				unsigned short* const out_red = static_cast<unsigned short*>(output_image.getRow(0, y));
+				unsigned short* const out_green = static_cast<unsigned short*>(output_image.getRow(1, y));
+				unsigned short* const out_blue = static_cast<unsigned short*>(output_image.getRow(2, y));
+				for (unsigned int x = 0; x < width; ++x) {
+					out_red[x] = rgb16[x * 4];
+					out_green[x] = rgb16[x * 4 + 1];
+					out_blue[x] = rgb16[x * 4 + 2];
+				}
+				break;
+			}
+		}
+	}
+
+	freeMemory(rgb);
+}
+
+void convertPreview(const ClutMethod& clut_method, const Image& input_image, Image& output_image, unsigned int factor, PreviewFilter filter)
+{
+	const unsigned int width = (input_image.getWidth() + factor - 1) / factor;
+	const unsigned int height = (input_image.getHeight() + factor - 1) / factor;
+	output_image.clearAndInitialize(width, height, false);
+
+	for (unsigned int y = 0; y < height; ++y) {
+		for (unsigned int x = 0; x < width; ++x) {
+			float rgb[4] __attribute__((aligned(16)));
+
+			switch (filter) {
+				case PREVIEW_BOX: {
+					const unsigned int start_x = x * factor;
+					const unsigned int start_y = y * factor;
+					const unsigned int end_x = std::min(input_image.getWidth(), start_x + factor);
+					const unsigned int end_y = std::min(input_image.getHeight(), start_y + factor);
+
+					float r = 0.0f;
+					float g = 0.0f;
+					float b = 0.0f;
+					for (unsigned int row = start_y; row < end_y; ++row) {
+						for (unsigned int column = start_x; column < end_x; ++column) {
+							r += input_image.getR(column, row);
+							g += input_image.getG(column, row);
+							b += input_image.getB(column, row);
+						}
+					}
+
+					const float scale = 1.0f / static_cast<float>((end_x - start_x) * (end_y - start_y));
+					rgb[0] = r * scale;
+					rgb[1] = g * scale;
+					rgb[2] = b * scale;
+					break;
+				}
+
+				case PREVIEW_BILINEAR: {
+					// Sample at the center of the covered block
+					const float fx = std::min(static_cast<float>(input_image.getWidth() - 1), std::max(0.0f, (x + 0.5f) * factor - 0.5f));
+					const float fy = std::min(static_cast<float>(input_image.getHeight() - 1), std::max(0.0f, (y + 0.5f) * factor - 0.5f));
+					const unsigned int x0 = fx;
+					const unsigned int y0 = fy;
+					const unsigned int x1 = std::min(input_image.getWidth() - 1, x0 + 1);
+					const unsigned int y1 = std::min(input_image.getHeight() - 1, y0 + 1);
+					const float dx = fx - x0;
+					const float dy = fy - y0;
+
+					rgb[0] =
+						(input_image.getR(x0, y0) * (1 - dx) + input_image.getR(x1, y0) * dx) * (1 - dy)
+						+ (input_image.getR(x0, y1) * (1 - dx) + input_image.getR(x1, y1) * dx) * dy;
+					rgb[1] =
+						(input_image.getG(x0, y0) * (1 - dx) + input_image.getG(x1, y0) * dx) * (1 - dy)
+						+ (input_image.getG(x0, y1) * (1 - dx) + input_image.getG(x1, y1) * dx) * dy;
+					rgb[2] =
+						(input_image.getB(x0, y0) * (1 - dx) + input_image.getB(x1, y0) * dx) * (1 - dy)
+						+ (input_image.getB(x0, y1) * (1 - dx) + input_image.getB(x1, y1) * dx) * dy;
+					break;
+				}
+			}
+
+			rgb[3] = 0.0f;
+			clut_method.convert(rgb);
+			output_image.setR(x, y, rgb[0]);
+			output_image.setG(x, y, rgb[1]);
+			output_image.setB(x, y, rgb[2]);
+		}
+	}
+}
+
+void convertProgressive(const ClutMethod& clut_method, const Image& input_image, Image& output_image, ProgressiveCallback* callback, unsigned int first_step)
+{
+	const unsigned int width = input_image.getWidth();
+	const unsigned int height = input_image.getHeight();
+	output_image.clearAndInitialize(width, height, false);
+	output_image.copyAlpha(input_image);
+
+	float* const rgb = reinterpret_cast<float*>(allocateMemory(static_cast<size_t>(width) * 4 * sizeof(float), 4 * sizeof(float)));
+
+	unsigned int step = 1;
+	while (step * 2 <= first_step) {
+		step *= 2;
+	}
+
+	for (bool first_pass = true; step; step /= 2, first_pass = false) {
+		for (unsigned int y = 0; y < height; y += step) {
+			// Pixels on the grid of the previous pass are done already
+			const bool previous_row = !first_pass && y % (2 * step) == 0;
+			const unsigned int start_x = previous_row ? step : 0;
+			const unsigned int stride = previous_row ? 2 * step : step;
+
+			float* const out_red = static_cast<float*>(output_image.getRow(0, y));
+			float* const out_green = static_cast<float*>(output_image.getRow(1, y));
+			float* const out_blue = static_cast<float*>(output_image.getRow(2, y));
+
+			if (stride == 1 && input_image.getPrecision() == Image::PRECISION_FLOAT) {
+				// Whole rows of the last pass, like convertRows()
+				loadFloatRow(
+					static_cast<const float*>(input_image.getRow(0, y)),
+					static_cast<const float*>(input_image.getRow(1, y)),
+					static_cast<const float*>(input_image.getRow(2, y)),
+					rgb,
+					width
+				);
+				clut_method.convertRow(rgb, width);
+				storeFloatRow(rgb, out_red, out_green, out_blue, width);
+				continue;
+			}
+
+			size_t count = 0;
+			if (input_image.getPrecision() == Image::PRECISION_FLOAT) {
+				const float* const red = static_cast<const float*>(input_image.getRow(0, y));
+				const float* const green = static_cast<const float*>(input_image.getRow(1, y));
+				const float* const blue = static_cast<const float*>(input_image.getRow(2, y));
+				for (unsigned int x = start_x; x < width; x += stride, ++count) {
+					rgb[count * 4] = red[x];
+					rgb[count * 4 + 1] = green[x];
+					rgb[count * 4 + 2] = blue[x];
+					rgb[count * 4 + 3] = 0.0f;
+				}
+			} else {
+				for (unsigned int x = start_x; x < width; x += stride, ++count) {
+					rgb[count * 4] = input_image.getR(x, y);
+					rgb[count * 4 + 1] = input_image.getG(x, y);
+					rgb[count * 4 + 2] = input_image.getB(x, y);
+					rgb[count * 4 + 3] = 0.0f;
+				}
+			}
+
+			clut_method.convertRow(rgb, count);
+
+			// Fills the step wide span of each converted pixel in its row
+			size_t pixel = 0;
+			for (unsigned int x = start_x; x < width; x += stride, ++pixel) {
+				const float r = std::max(0.0f, std::min(65535.0f, rgb[pixel * 4]));
+				const float g = std::max(0.0f, std::min(65535.0f, rgb[pixel * 4 + 1]));
+				const float b = std::max(0.0f, std::min(65535.0f, rgb[pixel * 4 + 2]));
+				const unsigned int end_x = std::min(width, x + step);
+				std::fill(out_red + x, out_red + end_x, r);
+				std::fill(out_green + x, out_green + end_x, g);
+				std::fill(out_blue + x, out_blue + end_x, b);
+			}
+
+			// All blocks of the band start in this row, so the rows below are copies
+			for (unsigned int row = y + 1; row < std::min(height, y + step); ++row) {
+				std::memcpy(output_image.getRow(0, row), out_red, width * sizeof(float));
+				std::memcpy(output_image.getRow(1, row), out_green, width * sizeof(float));
+				std::memcpy(output_image.getRow(2, row), out_blue, width * sizeof(float));
+			}
+		}
+
+		if (callback && !callback->passDone(step, output_image)) {
+			break;
+		}
+	}
+
+	freeMemory(rgb);
+}
@@ -0,0 +1,66 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#pragma once
+
+#include <cstddef>
+
+class ClutMethod;
+class Image;
+
+// Interleaves float plane rows into count aligned four float pixels for ClutMethod::convertRow()
+void loadFloatRow(const float* red, const float* green, const float* blue, float* rgb, size_t count);
+// Deinterleaves count aligned four float pixels into float plane rows, clamping to 0..65535
+void storeFloatRow(const float* rgb, float* red, float* green, float* blue, size_t count);
+
+// Converts a region of the input into the same region of the output, which must be big enough
+void convertRegion(const ClutMethod& clut_method, const Image& input_image, Image& output_image, unsigned int x, unsigned int y, unsigned int width, unsigned int height);
+
+// Converts the whole input, (re)initializing the output and copying the alpha plane
+void convertImage(const ClutMethod& clut_method, const Image& input_image, Image& output_image);
+
+// Converts row by row straight from and to the planes of the input's precision with ClutMethod::convertRow(), (re)initializing the output and copying the alpha plane
+void convertRows(const ClutMethod& clut_method, const Image& input_image, Image& output_image);
+
+enum PreviewFilter {
+	PREVIEW_BOX,
+	PREVIEW_BILINEAR
+};
+
+// Downsamples the input by an integer factor and converts each preview pixel in the same loop, (re)initializing the output
+void convertPreview(const ClutMethod& clut_method, const Image& input_image, Image& output_image, unsigned int factor, PreviewFilter filter);
+
+class ProgressiveCallback
+{
+public:
+	virtual ~ProgressiveCallback()
+	{
+	}
+
+	// Called after each pass with its step, the output is complete after step 1. Returning false stops the refinement.
+	virtual bool passDone(unsigned int step, const Image& output_image) = 0;
+};
+
+// Converts every first_step-th pixel in each dimension first, filling the
+// gaps by nearest neighbour, then refines with half the step down to 1.
+// Each pixel is converted once, (re)initializing the output.
+void convertProgressive(const ClutMethod& clut_method, const Image& input_image, Image& output_image, ProgressiveCallback* callback, unsigned int first_step = 8);
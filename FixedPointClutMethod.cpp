@@ -0,0 +1,220 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+
+#include <emmintrin.h>
+
+#include "FixedPointClutMethod.hpp"
+
+#include "Memory.hpp"
+
+namespace
+{
+
+	// Position in 16.16 fixed point, the weight of the upper corner has 16 bits
+	inline void getPosition(unsigned int value, unsigned int scale, unsigned int level, unsigned int& index, unsigned int& weight)
+	{
+		const unsigned int position = (static_cast<unsigned long long>(value) * scale) >> 8;
+		index = position >> 16;
+		weight = position & 0xFFFF;
+		if (index > level - 2) {
+			index = level - 2;
+			weight = 0xFFFF;
+		}
+	}
+
+	// Low four lanes weighted by 0x10000 - weight, high four lanes by weight,
+	// which is at least 1, so both fit into 16b and sum up to 0x10000
+	inline __m128i getWeights(unsigned int weight)
+	{
+		const short upper = std::max(1u, weight);
+		const short lower = 0x10000 - std::max(1u, weight);
+		return _mm_set_epi16(upper, upper, upper, upper, lower, lower, lower, lower);
+	}
+
+	// Interpolates the two pixels of v_pair into the low four lanes
+	inline __m128i interpolate(__m128i v_pair, __m128i v_weights)
+	{
+		const __m128i v_products = _mm_mulhi_epu16(v_pair, v_weights);
+		// Both products are truncated, so add one to round on average
+		return _mm_adds_epu16(_mm_add_epi16(v_products, _mm_srli_si128(v_products, 8)), _mm_set1_epi16(1));
+	}
+
+	inline __m128i getCorners(const unsigned short* clut_image, size_t index)
+	{
+		return _mm_loadu_si128(reinterpret_cast<const __m128i*>(clut_image + index * 4));
+	}
+
+}
+
+FixedPointClutMethod::FixedPointClutMethod() :
+	clut_storage(0),
+	clut_image(0),
+	clut_level(0),
+	position_scale(0),
+	strength(1.0f),
+	fixed_strength(0x10000)
+{
+}
+
+FixedPointClutMethod::~FixedPointClutMethod()
+{
+	freeMemory(clut_storage);
+}
+
+const char* FixedPointClutMethod::getDescription() const
+{
+	return "4 * 16b integer clut storage with fixed point interpolation";
+}
+
+const char* FixedPointClutMethod::getFilename() const
+{
+	return "fixed";
+}
+
+void FixedPointClutMethod::setClut(const Image& image, unsigned int level)
+{
+	freeMemory(clut_storage);
+	const size_t size = static_cast<size_t>(image.getWidth()) * image.getHeight();
+	clut_storage = reinterpret_cast<unsigned short*>(allocateMemory(size * 4 * sizeof(unsigned short), 4 * sizeof(unsigned short)));
+	size_t index = 0;
+	for (unsigned int y = 0; y < image.getHeight(); ++y) {
+		for (unsigned int x = 0; x < image.getWidth(); ++x) {
+			clut_storage[index] = image.getR(x, y);
+			++index;
+			clut_storage[index] = image.getG(x, y);
+			++index;
+			clut_storage[index] = image.getB(x, y);
+			index += 2;
+		}
+	}
+
+	clut_image = clut_storage;
+
+	clut_level = level * level;
+	position_scale = (static_cast<unsigned long long>(clut_level - 1) << 24) / 65535;
+}
+
+bool FixedPointClutMethod::setPackedClut(const unsigned short* packed_clut, unsigned int level)
+{
+	freeMemory(clut_storage);
+	clut_storage = 0;
+
+	clut_image = packed_clut;
+
+	clut_level = level * level;
+	position_scale = (static_cast<unsigned long long>(clut_level - 1) << 24) / 65535;
+
+	return true;
+}
+
+void FixedPointClutMethod::convert(float* rgb) const
+{
+	// convert16() loads all four lanes when blending with the strength
+	unsigned short value[4];
+	for (unsigned int channel = 0; channel < 3; ++channel) {
+		value[channel] = std::max(0.0f, std::min(65535.0f, rgb[channel]));
+	}
+	value[3] = 0;
+	convert16(value);
+	rgb[0] = value[0];
+	rgb[1] = value[1];
+	rgb[2] = value[2];
+}
+
+void FixedPointClutMethod::convertRow16(unsigned short* rgb, size_t count) const
+{
+	for (size_t pixel = 0; pixel < count; ++pixel) {
+		convert16(rgb + pixel * 4);
+	}
+}
+
+void FixedPointClutMethod::setStrength(float _strength)
+{
+	strength = _strength;
+	fixed_strength = strength * 65536.0f + 0.5f;
+}
+
+size_t FixedPointClutMethod::getClutFootprint() const
+{
+	if (!clut_image) {
+		return 0;
+	}
+	return static_cast<size_t>(clut_level) * clut_level * clut_level * 4 * sizeof(unsigned short);
+}
+
+void FixedPointClutMethod::convert16(unsigned short* rgb) const
+{
+	const unsigned int level = clut_level;
+
+	unsigned int red;
+	unsigned int green;
+	unsigned int blue;
+	unsigned int r;
+	unsigned int g;
+	unsigned int b;
+	getPosition(rgb[0], position_scale, level, red, r);
+	getPosition(rgb[1], position_scale, level, green, g);
+	getPosition(rgb[2], position_scale, level, blue, b);
+
+	const unsigned int level_square = level * level;
+
+	const size_t color = red + green * level + static_cast<size_t>(blue) * level_square;
+
+	const __m128i v_r = getWeights(r);
+	const __m128i v_g = getWeights(g);
+
+	const __m128i v_tmp1 = interpolate(
+		_mm_unpacklo_epi64(
+			interpolate(getCorners(clut_image, color), v_r),
+			interpolate(getCorners(clut_image, color + level), v_r)
+		),
+		v_g
+	);
+	const __m128i v_tmp2 = interpolate(
+		_mm_unpacklo_epi64(
+			interpolate(getCorners(clut_image, color + level_square), v_r),
+			interpolate(getCorners(clut_image, color + level + level_square), v_r)
+		),
+		v_g
+	);
+
+	__m128i v_out = interpolate(_mm_unpacklo_epi64(v_tmp1, v_tmp2), getWeights(b));
+
+	if (fixed_strength != 0x10000) {
+		if (fixed_strength >= 0 && fixed_strength < 0x10000) {
+			v_out = interpolate(_mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(rgb)), v_out), getWeights(fixed_strength));
+		} else {
+			// Extrapolating strengths leave the 16b range
+			unsigned short out[8] __attribute__((aligned(16)));
+			_mm_store_si128(reinterpret_cast<__m128i*>(out), v_out);
+			for (unsigned int channel = 0; channel < 3; ++channel) {
+				const float value = rgb[channel] + strength * (out[channel] - rgb[channel]);
+				out[channel] = std::max(0.0f, std::min(65535.0f, value));
+			}
+			v_out = _mm_load_si128(reinterpret_cast<const __m128i*>(out));
+		}
+	}
+
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(rgb), v_out);
+}
@@ -0,0 +1,146 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+
+#include "GigapixelBenchMode.hpp"
+
+#include "Arguments.hpp"
+#include "Conversion.hpp"
+#include "Exception.hpp"
+#include "HaldClut.hpp"
+#include "Image.hpp"
+#include "PpmImageReader.hpp"
+#include "SseClutMethod.hpp"
+#include "SystemInfo.hpp"
+#include "Timer.hpp"
+
+namespace
+{
+
+	// Smooth gradients with some noise, so the CLUT is accessed like for a photo
+	void fillPanorama(Image& image)
+	{
+		const float scale_x = 65535.0f / static_cast<float>(std::max(1u, image.getWidth() - 1));
+		const float scale_y = 65535.0f / static_cast<float>(std::max(1u, image.getHeight() - 1));
+		unsigned int noise = 1;
+		for (unsigned int y = 0; y < image.getHeight(); ++y) {
+			for (unsigned int x = 0; x < image.getWidth(); ++x) {
+				noise = noise * 1664525u + 1013904223u;
+				image.setR(x, y, x * scale_x);
+				image.setG(x, y, y * scale_y);
+				image.setB(x, y, (noise >> 16) & 0xFFFF);
+			}
+		}
+	}
+
+}
+
+const char* GigapixelBenchMode::getName() const
+{
+	return "--gigapixel";
+}
+
+const char* GigapixelBenchMode::getUsage() const
+{
+	return "CLUT [MEGAPIXELS] [WIDTH]";
+}
+
+unsigned int GigapixelBenchMode::getMinimumArgumentCount() const
+{
+	return 1;
+}
+
+void GigapixelBenchMode::run(const std::vector<std::string>& args)
+{
+	std::ifstream clut_file(args[0].c_str());
+	Image clut_image;
+	PpmImageReader().load(clut_file, clut_image);
+
+	const unsigned int level = getHaldClutLevel(clut_image);
+	if (level < 2) {
+		throw Exception("CLUT image has wrong dimensions.", __FILE__, __LINE__);
+	}
+
+	std::vector<unsigned int> sizes = getNumberList("16,64,256,1024,2048");
+	if (args.size() > 1) {
+		sizes = getNumberList(args[1]);
+	}
+
+	unsigned int width = 32768;
+	if (args.size() > 2) {
+		width = getNumber(args[2]);
+	}
+	if (!width) {
+		throw Exception("Width must not be zero.", __FILE__, __LINE__);
+	}
+
+	SseClutMethod clut_method;
+	clut_method.setClut(clut_image, level);
+	clut_image.clearAndInitialize(0, 0);
+
+	for (std::vector<unsigned int>::const_iterator sizes_it = sizes.begin(); sizes_it != sizes.end(); ++sizes_it) {
+		const unsigned long long pixels_wanted = static_cast<unsigned long long>(*sizes_it) * 1000000;
+		const unsigned int height = std::max(1ull, (pixels_wanted + width - 1) / width);
+		const unsigned long long pixels = static_cast<unsigned long long>(width) * height;
+		// Converted in place, so there are only the three input planes
+		const unsigned long long bytes = pixels * 3 * sizeof(float);
+
+		std::cout << *sizes_it << " MP (" << width << 'x' << height << ", " << pixels * 3 << " samples, " << (bytes >> 20) << " MiB): ";
+
+		const SystemInfo system_info;
+		if (system_info.getAvailableMemory() && bytes > system_info.getAvailableMemory()) {
+			std::cout << "skipped, only " << (system_info.getAvailableMemory() >> 20) << " MiB available" << std::endl;
+			continue;
+		}
+
+		Timer allocation_timer;
+		Image image;
+		image.clearAndInitialize(width, height, false);
+		allocation_timer.stop();
+
+		Timer fill_timer;
+		fillPanorama(image);
+		fill_timer.stop();
+
+		Timer convert_timer;
+		convertRegion(clut_method, image, image, 0, 0, width, height);
+		convert_timer.stop();
+
+		const double seconds = static_cast<double>(std::max(1ull, convert_timer.getNSecs())) / 1.0e9;
+		std::cout
+			<< "allocation "
+			<< allocation_timer.getMSecs()
+			<< "ms, fill "
+			<< fill_timer.getMSecs()
+			<< "ms, convert "
+			<< convert_timer.getMSecs()
+			<< "ms ("
+			<< static_cast<double>(pixels) / seconds / 1.0e6
+			<< " Mpix/s, "
+			<< static_cast<double>(bytes) * 2.0 / seconds / 1.0e9
+			<< " GB/s)"
+			<< std::endl;
+	}
+}
@@ -0,0 +1,94 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include "HaldClut.hpp"
+
+#include "Exception.hpp"
+#include "Image.hpp"
+#include "OptimizedClutMethod.hpp"
+
+unsigned int getHaldClutLevel(const Image& image)
+{
+	if (image.getWidth() == image.getHeight()) {
+		unsigned int level = 1;
+		while (level * level * level < image.getWidth()) {
+			++level;
+		}
+		if (level * level * level == image.getWidth()) {
+			return level;
+		}
+	}
+	return 0;
+}
+
+void createIdentityHaldClut(unsigned int level, Image& image)
+{
+	const unsigned int size = level * level * level;
+	const unsigned int colors = level * level;
+	const float scale = 65535.0f / static_cast<float>(colors - 1);
+
+	image.clearAndInitialize(size, size, false);
+
+	unsigned int color = 0;
+	for (unsigned int y = 0; y < size; ++y) {
+		for (unsigned int x = 0; x < size; ++x) {
+			image.setR(x, y, static_cast<float>(color % colors) * scale);
+			image.setG(x, y, static_cast<float>(color / colors % colors) * scale);
+			image.setB(x, y, static_cast<float>(color / (colors * colors)) * scale);
+			++color;
+		}
+	}
+}
+
+void composeHaldCluts(const std::vector<const Image*>& clut_images, Image& result)
+{
+	if (clut_images.empty() || getHaldClutLevel(*clut_images.front()) < 2) {
+		throw Exception("CLUT image has wrong dimensions.", __FILE__, __LINE__);
+	}
+
+	result = *clut_images.front();
+
+	for (std::vector<const Image*>::const_iterator clut_images_it = clut_images.begin() + 1; clut_images_it != clut_images.end(); ++clut_images_it) {
+		const unsigned int level = getHaldClutLevel(**clut_images_it);
+		if (level < 2) {
+			throw Exception("CLUT image has wrong dimensions.", __FILE__, __LINE__);
+		}
+
+		// Float storage, so the composition doesn't add quantization errors
+		OptimizedClutMethod clut_method;
+		clut_method.setClut(**clut_images_it, level);
+
+		for (unsigned int y = 0; y < result.getHeight(); ++y) {
+			for (unsigned int x = 0; x < result.getWidth(); ++x) {
+				float rgb[4] __attribute__((aligned(16)));
+				rgb[0] = result.getR(x, y);
+				rgb[1] = result.getG(x, y);
+				rgb[2] = result.getB(x, y);
+				rgb[3] = 0.0f;
+				clut_method.convert(rgb);
+				result.setR(x, y, rgb[0]);
+				result.setG(x, y, rgb[1]);
+				result.setB(x, y, rgb[2]);
+			}
+		}
+	}
+}
@@ -0,0 +1,37 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#pragma once
+
+#include <vector>
+
+class Image;
+
+// Returns the level of a HaldCLUT image or 0 if the dimensions don't fit
+unsigned int getHaldClutLevel(const Image& image);
+
+// Fills the image with an identity HaldCLUT of the given level
+void createIdentityHaldClut(unsigned int level, Image& image);
+
+// Pushes the lattice of the first CLUT through all following ones, so the
+// result (of the first CLUT's level) applies the whole chain in one lookup
+void composeHaldCluts(const std::vector<const Image*>& clut_images, Image& result);
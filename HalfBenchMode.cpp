@@ -0,0 +1,135 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+
+#include "HalfBenchMode.hpp"
+
+#include "Arguments.hpp"
+#include "Conversion.hpp"
+#include "Exception.hpp"
+#include "HaldClut.hpp"
+#include "HalfFloat.hpp"
+#include "Image.hpp"
+#include "PpmImageReader.hpp"
+#include "SseClutMethod.hpp"
+#include "Timer.hpp"
+
+namespace
+{
+
+	void printDifference(const char* label, const Image::Difference& difference, const Image& image)
+	{
+		const double samples = static_cast<double>(image.getWidth()) * image.getHeight() * 3;
+		std::cout
+			<< label
+			<< static_cast<double>(difference.absolute) / std::max(1.0, samples)
+			<< " average (Rmax "
+			<< difference.max_r
+			<< ", Gmax "
+			<< difference.max_g
+			<< ", Bmax "
+			<< difference.max_b
+			<< ')'
+			<< std::endl;
+	}
+
+}
+
+const char* HalfBenchMode::getName() const
+{
+	return "--half";
+}
+
+const char* HalfBenchMode::getUsage() const
+{
+	return "INPUT CLUT [CYCLES]";
+}
+
+unsigned int HalfBenchMode::getMinimumArgumentCount() const
+{
+	return 2;
+}
+
+void HalfBenchMode::run(const std::vector<std::string>& args)
+{
+	if (!isHalfFloatSupported()) {
+		throw Exception("Half precision planes need a CPU with F16C.", __FILE__, __LINE__);
+	}
+
+	std::ifstream input_file(args[0].c_str());
+	Image input_image;
+	PpmImageReader().load(input_file, input_image);
+
+	std::ifstream clut_file(args[1].c_str());
+	Image clut_image;
+	PpmImageReader().load(clut_file, clut_image);
+
+	const unsigned int level = getHaldClutLevel(clut_image);
+	if (level < 2) {
+		throw Exception("CLUT image has wrong dimensions.", __FILE__, __LINE__);
+	}
+
+	unsigned int cycles = 10;
+	if (args.size() > 2) {
+		cycles = std::max(1u, getNumber(args[2]));
+	}
+
+	SseClutMethod clut_method;
+	clut_method.setClut(clut_image, level);
+
+	Image half_input_image;
+	half_input_image.clearAndInitialize(input_image.getWidth(), input_image.getHeight(), false, Image::PRECISION_HALF);
+	for (unsigned int y = 0; y < input_image.getHeight(); ++y) {
+		for (unsigned int x = 0; x < input_image.getWidth(); ++x) {
+			half_input_image.setR(x, y, input_image.getR(x, y));
+			half_input_image.setG(x, y, input_image.getG(x, y));
+			half_input_image.setB(x, y, input_image.getB(x, y));
+		}
+	}
+
+	Image float_output_image;
+	Timer float_timer;
+	for (unsigned int cycle = 0; cycle < cycles; ++cycle) {
+		convertRows(clut_method, input_image, float_output_image);
+	}
+	float_timer.stop();
+
+	Image half_output_image;
+	Timer half_timer;
+	for (unsigned int cycle = 0; cycle < cycles; ++cycle) {
+		convertRows(clut_method, half_input_image, half_output_image);
+	}
+	half_timer.stop();
+
+	const double pixels = static_cast<double>(input_image.getWidth()) * input_image.getHeight() * cycles;
+	const double float_seconds = static_cast<double>(std::max(1ull, float_timer.getNSecs())) / 1.0e9;
+	const double half_seconds = static_cast<double>(std::max(1ull, half_timer.getNSecs())) / 1.0e9;
+
+	std::cout << "Float:      " << float_timer.getMSecs() / cycles << "ms (" << pixels / float_seconds / 1.0e6 << " Mpix/s, 24 B/pixel of planes)" << std::endl;
+	std::cout << "Half:       " << half_timer.getMSecs() / cycles << "ms (" << pixels / half_seconds / 1.0e6 << " Mpix/s, 12 B/pixel of planes)" << std::endl;
+	std::cout << "Speedup:    " << float_seconds / half_seconds << std::endl;
+	printDifference("Input:      ", input_image.compare(half_input_image), input_image);
+	printDifference("Output:     ", float_output_image.compare(half_output_image), float_output_image);
+}
@@ -0,0 +1,107 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <immintrin.h>
+
+#include "HalfFloat.hpp"
+
+namespace
+{
+
+	const float to_half_scale = 1.0f / 65535.0f;
+	const float from_half_scale = 65535.0f;
+
+	// Like std::max(0.0f, std::min(65535.0f, value)), but without instantiating
+	// the std templates, whose weak copies would carry F16C code into other files
+	inline float clamp(float value)
+	{
+		const float upper = value < 65535.0f ? value : 65535.0f;
+		return 0.0f < upper ? upper : 0.0f;
+	}
+
+}
+
+bool isHalfFloatSupported()
+{
+	return __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+}
+
+__attribute__((target("f16c"))) float decodeHalf(unsigned short half)
+{
+	return _cvtsh_ss(half) * from_half_scale;
+}
+
+__attribute__((target("f16c"))) unsigned short encodeHalf(float value)
+{
+	return _cvtss_sh(clamp(value) * to_half_scale, _MM_FROUND_TO_NEAREST_INT);
+}
+
+__attribute__((target("f16c"))) void loadHalfRow(const unsigned short* red, const unsigned short* green, const unsigned short* blue, float* rgb, size_t count)
+{
+	const __m128 v_scale = _mm_set_ps1(from_half_scale);
+
+	size_t pixel = 0;
+	for (; pixel + 4 <= count; pixel += 4) {
+		__m128 v_r = _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(red + pixel))) * v_scale;
+		__m128 v_g = _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(green + pixel))) * v_scale;
+		__m128 v_b = _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(blue + pixel))) * v_scale;
+		__m128 v_zero = _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS(v_r, v_g, v_b, v_zero);
+		_mm_store_ps(rgb + pixel * 4, v_r);
+		_mm_store_ps(rgb + pixel * 4 + 4, v_g);
+		_mm_store_ps(rgb + pixel * 4 + 8, v_b);
+		_mm_store_ps(rgb + pixel * 4 + 12, v_zero);
+	}
+	for (; pixel < count; ++pixel) {
+		rgb[pixel * 4] = decodeHalf(red[pixel]);
+		rgb[pixel * 4 + 1] = decodeHalf(green[pixel]);
+		rgb[pixel * 4 + 2] = decodeHalf(blue[pixel]);
+		rgb[pixel * 4 + 3] = 0.0f;
+	}
+}
+
+__attribute__((target("f16c"))) void storeHalfRow(const float* rgb, unsigned short* red, unsigned short* green, unsigned short* blue, size_t count)
+{
+	const __m128 v_scale = _mm_set_ps1(to_half_scale);
+	const __m128 v_min = _mm_setzero_ps();
+	const __m128 v_max = _mm_set_ps1(65535.0f);
+
+	size_t pixel = 0;
+	for (; pixel + 4 <= count; pixel += 4) {
+		__m128 v_r = _mm_load_ps(rgb + pixel * 4);
+		__m128 v_g = _mm_load_ps(rgb + pixel * 4 + 4);
+		__m128 v_b = _mm_load_ps(rgb + pixel * 4 + 8);
+		__m128 v_x = _mm_load_ps(rgb + pixel * 4 + 12);
+		_MM_TRANSPOSE4_PS(v_r, v_g, v_b, v_x);
+		v_r = _mm_min_ps(v_max, _mm_max_ps(v_min, v_r)) * v_scale;
+		v_g = _mm_min_ps(v_max, _mm_max_ps(v_min, v_g)) * v_scale;
+		v_b = _mm_min_ps(v_max, _mm_max_ps(v_min, v_b)) * v_scale;
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(red + pixel), _mm_cvtps_ph(v_r, _MM_FROUND_TO_NEAREST_INT));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(green + pixel), _mm_cvtps_ph(v_g, _MM_FROUND_TO_NEAREST_INT));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(blue + pixel), _mm_cvtps_ph(v_b, _MM_FROUND_TO_NEAREST_INT));
+	}
+	for (; pixel < count; ++pixel) {
+		red[pixel] = encodeHalf(rgb[pixel * 4]);
+		green[pixel] = encodeHalf(rgb[pixel * 4 + 1]);
+		blue[pixel] = encodeHalf(rgb[pixel * 4 + 2]);
+	}
+}
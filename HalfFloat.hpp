@@ -0,0 +1,38 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#pragma once
+
+#include <cstddef>
+
+// binary16 conversion with F16C, which these functions are compiled for, so
+// check isHalfFloatSupported() before calling anything else. Halves hold the
+// 0..65535 range scaled to 0..1, as their maximum is 65504.
+
+bool isHalfFloatSupported();
+
+float decodeHalf(unsigned short half);
+unsigned short encodeHalf(float value);
+
+// Between planar half rows and count aligned four float pixels
+void loadHalfRow(const unsigned short* red, const unsigned short* green, const unsigned short* blue, float* rgb, size_t count);
+void storeHalfRow(const float* rgb, unsigned short* red, unsigned short* green, unsigned short* blue, size_t count);
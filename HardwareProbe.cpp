@@ -0,0 +1,171 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <xmmintrin.h>
+
+#include "HardwareProbe.hpp"
+
+#include "CacheFiles.hpp"
+#include "Exception.hpp"
+#include "KernelSelection.hpp"
+#include "Memory.hpp"
+#include "SystemInfo.hpp"
+#include "Timer.hpp"
+
+namespace
+{
+
+	const unsigned int probe_runs = 3;
+
+}
+
+double measureMemoryBandwidth()
+{
+	// Four times the L3 cache, but at least 32 MiB and at most 256 MiB per array
+	const size_t array_size = std::min<size_t>(256 << 20, std::max<size_t>(32 << 20, 4 * SystemInfo().getCacheSize(3)));
+	const size_t count = array_size / sizeof(float);
+
+	float* const a = reinterpret_cast<float*>(allocateMemory(count * sizeof(float), 64));
+	float* b = 0;
+	float* c = 0;
+	try {
+		b = reinterpret_cast<float*>(allocateMemory(count * sizeof(float), 64));
+		c = reinterpret_cast<float*>(allocateMemory(count * sizeof(float), 64));
+	}
+	catch (...) {
+		freeMemory(b);
+		freeMemory(a);
+		throw;
+	}
+
+	std::fill(a, a + count, 0.0f);
+	std::fill(b, b + count, 1.0f);
+	std::fill(c, c + count, 2.0f);
+
+	const __m128 v_scalar = _mm_set_ps1(3.0f);
+	unsigned long long best_nsecs = ~0ull;
+
+	for (unsigned int run = 0; run < probe_runs; ++run) {
+		Timer timer;
+		for (size_t i = 0; i < count; i += 4) {
+			_mm_stream_ps(a + i, _mm_load_ps(b + i) + v_scalar * _mm_load_ps(c + i));
+		}
+		_mm_sfence();
+		timer.stop();
+		best_nsecs = std::min(best_nsecs, std::max(1ull, timer.getNSecs()));
+	}
+
+	// Keep the compiler from dropping the stores
+	volatile float sink = a[count / 2];
+	static_cast<void>(sink);
+
+	freeMemory(a);
+	freeMemory(b);
+	freeMemory(c);
+
+	return 3.0 * array_size * 1.0e9 / static_cast<double>(best_nsecs);
+}
+
+double measurePeakFlops()
+{
+	const unsigned int iterations = 10000000;
+
+	unsigned long long best_nsecs = ~0ull;
+	float result[4] __attribute__((aligned(16)));
+
+	for (unsigned int run = 0; run < probe_runs; ++run) {
+		const __m128 v_mul = _mm_set_ps1(0.999999f);
+		const __m128 v_add = _mm_set_ps1(0.000001f);
+		__m128 v_acc[8];
+		for (unsigned int chain = 0; chain < 8; ++chain) {
+			v_acc[chain] = _mm_set_ps1(static_cast<float>(chain));
+		}
+
+		Timer timer;
+		for (unsigned int iteration = 0; iteration < iterations; ++iteration) {
+			for (unsigned int chain = 0; chain < 8; ++chain) {
+				v_acc[chain] = v_acc[chain] * v_mul + v_add;
+			}
+		}
+		timer.stop();
+		best_nsecs = std::min(best_nsecs, std::max(1ull, timer.getNSecs()));
+
+		__m128 v_sum = v_acc[0];
+		for (unsigned int chain = 1; chain < 8; ++chain) {
+			v_sum = v_sum + v_acc[chain];
+		}
+		_mm_store_ps(result, v_sum);
+	}
+
+	// Keep the compiler from dropping the chains
+	volatile float sink = result[0];
+	static_cast<void>(sink);
+
+	// 8 chains * 4 lanes * (1 mul + 1 add) per iteration
+	return 64.0 * iterations * 1.0e9 / static_cast<double>(best_nsecs);
+}
+
+HardwareLimits getHardwareLimits()
+{
+	const std::string path = getCachePath("hardware");
+	const std::string machine = KernelChoices::getMachine();
+
+	// One "BANDWIDTH PEAK_FLOPS MACHINE" line per machine
+	std::ostringstream contents;
+	std::ifstream file(path.c_str());
+	std::string line;
+	while (std::getline(file, line)) {
+		std::istringstream stream(line);
+		HardwareLimits limits;
+		std::string line_machine;
+		if (stream >> limits.bandwidth >> limits.peak_flops) {
+			stream >> std::ws;
+			std::getline(stream, line_machine);
+			if (line_machine == machine) {
+				limits.measured = false;
+				return limits;
+			}
+			contents << line << '\n';
+		}
+	}
+
+	HardwareLimits limits;
+	limits.bandwidth = measureMemoryBandwidth();
+	limits.peak_flops = measurePeakFlops();
+	limits.measured = true;
+
+	contents.precision(17);
+	contents << limits.bandwidth << ' ' << limits.peak_flops << ' ' << machine << '\n';
+	try {
+		writeCacheFile(path, contents.str());
+	}
+	catch (const Exception&) {
+		// Probed again next time
+	}
+
+	return limits;
+}
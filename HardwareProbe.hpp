@@ -0,0 +1,42 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#pragma once
+
+// STREAM-style triad over buffers exceeding the last level cache, in bytes per second
+double measureMemoryBandwidth();
+
+// Independent SSE multiply and add chains, in floating point operations per second
+double measurePeakFlops();
+
+struct HardwareLimits {
+	// Bytes per second
+	double bandwidth;
+	// Floating point operations per second
+	double peak_flops;
+	// False if read from the cache
+	bool measured;
+};
+
+// Probes once per machine (see KernelChoices::getMachine()) and keeps the
+// result in getCachePath("hardware"), delete it to probe again
+HardwareLimits getHardwareLimits();
@@ -0,0 +1,176 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+
+#include "HugePageBenchMode.hpp"
+
+#include "Arguments.hpp"
+#include "ClutMethod.hpp"
+#include "ClutMethods.hpp"
+#include "Exception.hpp"
+#include "HaldClut.hpp"
+#include "Image.hpp"
+#include "Memory.hpp"
+#include "PpmImageReader.hpp"
+#include "TestBench.hpp"
+#include "Timer.hpp"
+#include "TlbMissCounter.hpp"
+
+namespace
+{
+
+	std::string readTransparentHugePages()
+	{
+		std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+		std::string line;
+		std::getline(file, line);
+		if (file.fail()) {
+			return "unknown";
+		}
+		return line;
+	}
+
+	// Anonymous memory of this process currently backed by transparent huge pages, in KiB
+	unsigned long long readAnonHugePages()
+	{
+		std::ifstream file("/proc/self/smaps_rollup");
+		std::string line;
+		while (std::getline(file, line)) {
+			if (line.compare(0, 14, "AnonHugePages:") == 0) {
+				unsigned long long kib = 0;
+				std::istringstream(line.substr(14)) >> kib;
+				return kib;
+			}
+		}
+		return 0;
+	}
+
+	std::string formatMisses(const TlbMissCounter& counter)
+	{
+		if (!counter.isAvailable()) {
+			return "n/a";
+		}
+		std::ostringstream res;
+		res << counter.getCount();
+		return res.str();
+	}
+
+}
+
+const char* HugePageBenchMode::getName() const
+{
+	return "--hugepages";
+}
+
+const char* HugePageBenchMode::getUsage() const
+{
+	return "INPUT CLUT [CYCLES]";
+}
+
+unsigned int HugePageBenchMode::getMinimumArgumentCount() const
+{
+	return 2;
+}
+
+void HugePageBenchMode::run(const std::vector<std::string>& args)
+{
+	std::ifstream input_file(args[0].c_str());
+	Image input_image;
+	PpmImageReader().load(input_file, input_image);
+
+	std::ifstream clut_file(args[1].c_str());
+	Image clut_image;
+	PpmImageReader().load(clut_file, clut_image);
+
+	if (getHaldClutLevel(clut_image) < 2) {
+		throw Exception("CLUT image has wrong dimensions.", __FILE__, __LINE__);
+	}
+
+	unsigned int cycles = 3;
+	if (args.size() > 2) {
+		cycles = std::max(1u, getNumber(args[2]));
+	}
+
+	std::cout << "THP:        " << readTransparentHugePages() << std::endl;
+
+	TlbMissCounter counter;
+	if (!counter.isAvailable()) {
+		std::cout << "dTLB:       no perf counter available" << std::endl;
+	}
+	std::cout << std::endl << "  method        pages      time   dTLB misses   huge    speedup" << std::endl;
+
+	const std::vector<ClutMethod*> clut_methods = createClutMethods();
+
+	try {
+		for (std::vector<ClutMethod*>::const_iterator clut_methods_it = clut_methods.begin(); clut_methods_it != clut_methods.end(); ++clut_methods_it) {
+			ClutMethod* const clut_method = *clut_methods_it;
+
+			unsigned long long nsecs[2];
+			for (unsigned int huge = 0; huge < 2; ++huge) {
+				setHugePages(huge);
+
+				// Copy the input, so its planes are allocated with the current setting, too
+				const Image input_copy(input_image);
+				TestBench test_bench(input_copy, clut_image);
+
+				counter.start();
+				const Timer timer = test_bench.run(clut_method, cycles);
+				counter.stop();
+				nsecs[huge] = timer.getNSecs();
+
+				std::cout
+					<< "  "
+					<< std::left
+					<< std::setw(12)
+					<< (huge ? "" : clut_method->getFilename())
+					<< std::right
+					<< std::setw(7)
+					<< (huge ? "2 MiB" : "4 KiB")
+					<< std::setw(8)
+					<< timer.getMSecs() / cycles
+					<< "ms"
+					<< std::setw(14)
+					<< formatMisses(counter)
+					<< std::setw(8)
+					<< (readAnonHugePages() >> 10)
+					<< " MiB";
+				if (huge) {
+					std::cout << std::setw(11) << static_cast<float>(nsecs[0]) / static_cast<float>(std::max(1ull, nsecs[1]));
+				}
+				std::cout << std::endl;
+			}
+		}
+	}
+	catch (...) {
+		setHugePages(false);
+		destroyClutMethods(clut_methods);
+		throw;
+	}
+
+	setHugePages(false);
+	destroyClutMethods(clut_methods);
+}
@@ -21,28 +21,101 @@
  */
 
 #include <algorithm>
+#include <map>
+#include <utility>
 
-#include <xmmintrin.h>
+#include <pthread.h>
 
 #include "Image.hpp"
 
+#include "Exception.hpp"
+#include "HalfFloat.hpp"
+#include "Memory.hpp"
+
 namespace
 {
 
-	float get(const float* plane, unsigned int width, unsigned int height, unsigned int x, unsigned int y)
+	// Plane chunks of destroyed images, by size and huge page backing, looked up
+	// with the backing a fresh allocation of that size would get
+	typedef std::multimap<std::pair<size_t, bool>, char*> Pool;
+
+	// Beyond this, freed chunks go back to the system
+	const size_t max_pooled_bytes = 512 << 20;
+
+	pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+	Pool pool;
+	size_t pooled_bytes = 0;
+	Image::Statistics statistics = {
+		0,
+		0,
+		0
+	};
+
+	// In bytes
+	char* acquireChunk(size_t size)
+	{
+		pthread_mutex_lock(&pool_mutex);
+		const Pool::iterator pool_it = pool.find(std::make_pair(size, usesHugePages(size)));
+		if (pool_it != pool.end()) {
+			char* const plane = pool_it->second;
+			pool.erase(pool_it);
+			pooled_bytes -= size;
+			++statistics.pooled;
+			pthread_mutex_unlock(&pool_mutex);
+			return plane;
+		}
+		++statistics.allocations;
+		pthread_mutex_unlock(&pool_mutex);
+
+		return reinterpret_cast<char*>(allocateMemory(size, 4 * sizeof(float)));
+	}
+
+	void releaseChunk(char* plane, size_t size)
+	{
+		if (!plane) {
+			return;
+		}
+
+		pthread_mutex_lock(&pool_mutex);
+		if (pooled_bytes + size <= max_pooled_bytes) {
+			pool.insert(std::make_pair(std::make_pair(size, isHugePageBacked(plane)), plane));
+			pooled_bytes += size;
+			plane = 0;
+		}
+		pthread_mutex_unlock(&pool_mutex);
+
+		freeMemory(plane);
+	}
+
+	void countCopy(size_t bytes)
 	{
-		if (x < width && y < height) {
-			const size_t index = static_cast<size_t>(width) * y + x;
-			return plane[index];
+		pthread_mutex_lock(&pool_mutex);
+		statistics.bytes_copied += bytes;
+		pthread_mutex_unlock(&pool_mutex);
+	}
+
+	// Per plane chunk, so a chunk stays far below any address space fragmentation
+	const size_t max_chunk_bytes = 64 << 20;
+
+	inline size_t getSampleSize(Image::Precision precision)
+	{
+		return precision == Image::PRECISION_FLOAT ? sizeof(float) : sizeof(unsigned short);
+	}
+
+	// The first row of each chunk is its start
+	void copyPlane(char* const* source_rows, char** destination_rows, size_t row_size, unsigned int height, unsigned int chunk_shift)
+	{
+		for (size_t row = 0; row < height; row += static_cast<size_t>(1) << chunk_shift) {
+			const size_t size = row_size * std::min<size_t>(static_cast<size_t>(1) << chunk_shift, height - row);
+			std::copy(source_rows[row], source_rows[row] + size, destination_rows[row]);
 		}
-		return 0.0f;
 	}
 
-	void set(float* plane, unsigned int width, unsigned int height, unsigned int x, unsigned int y, float value)
+	void fillPlane(char** rows, size_t row_size, unsigned int height, unsigned int chunk_shift)
 	{
-		if (x < width && y < height) {
-			const size_t index = static_cast<size_t>(width) * y + x;
-			plane[index] = std::max(0.0f, std::min(65535.0f, value));
+		for (size_t row = 0; row < height; row += static_cast<size_t>(1) << chunk_shift) {
+			const size_t size = row_size * std::min<size_t>(static_cast<size_t>(1) << chunk_shift, height - row);
+			std::fill(rows[row], rows[row] + size, 0);
 		}
 	}
 
@@ -51,75 +124,132 @@ namespace
 Image::Image() :
 	width(0),
 	height(0),
+	precision(PRECISION_FLOAT),
+	chunk_shift(0),
+	chunk_count(0),
 	red(0),
 	green(0),
-	blue(0)
+	blue(0),
+	alpha(0)
 {
 }
 
 Image::~Image()
 {
-	_mm_free(red);
-	_mm_free(green);
-	_mm_free(blue);
+	releasePlanes();
 }
 
 Image::Image(const Image& other) :
 	width(other.width),
-	height(other.height)
+	height(other.height),
+	precision(other.precision),
+	chunk_shift(0),
+	chunk_count(0),
+	red(0),
+	green(0),
+	blue(0),
+	alpha(0)
 {
-	const size_t size = static_cast<size_t>(width) * height;
+	allocatePlanes();
 
-	red = reinterpret_cast<float*>(_mm_malloc(size * sizeof(float), 4 * sizeof(float)));
-	green = reinterpret_cast<float*>(_mm_malloc(size * sizeof(float), 4 * sizeof(float)));
-	blue = reinterpret_cast<float*>(_mm_malloc(size * sizeof(float), 4 * sizeof(float)));
+	copyPlane(other.red, red, width * getSampleSize(precision), height, chunk_shift);
+	copyPlane(other.green, green, width * getSampleSize(precision), height, chunk_shift);
+	copyPlane(other.blue, blue, width * getSampleSize(precision), height, chunk_shift);
+	countCopy(static_cast<size_t>(width) * height * 3 * getSampleSize(precision));
 
-	std::copy(other.red, other.red + size, red);
-	std::copy(other.green, other.green + size, green);
-	std::copy(other.blue, other.blue + size, blue);
+	copyAlpha(other);
 }
 
 Image& Image::operator =(const Image& other)
 {
 	if (this != &other) {
-		_mm_free(red);
-		_mm_free(green);
-		_mm_free(blue);
-
-		width = other.width;
-		height = other.height;
-
-		const size_t size = static_cast<size_t>(width) * height;
+		if (width != other.width || height != other.height || precision != other.precision) {
+			releasePlanes();
+			width = other.width;
+			height = other.height;
+			precision = other.precision;
+			allocatePlanes();
+		}
 
-		red = reinterpret_cast<float*>(_mm_malloc(size * sizeof(float), 4 * sizeof(float)));
-		green = reinterpret_cast<float*>(_mm_malloc(size * sizeof(float), 4 * sizeof(float)));
-		blue = reinterpret_cast<float*>(_mm_malloc(size * sizeof(float), 4 * sizeof(float)));
+		copyPlane(other.red, red, width * getSampleSize(precision), height, chunk_shift);
+		copyPlane(other.green, green, width * getSampleSize(precision), height, chunk_shift);
+		copyPlane(other.blue, blue, width * getSampleSize(precision), height, chunk_shift);
+		countCopy(static_cast<size_t>(width) * height * 3 * getSampleSize(precision));
 
-		std::copy(other.red, other.red + size, red);
-		std::copy(other.green, other.green + size, green);
-		std::copy(other.blue, other.blue + size, blue);
+		copyAlpha(other);
 	}
 	return *this;
 }
 
-void Image::clearAndInitialize(unsigned int width, unsigned int height)
+Image::Image(Image&& other) :
+	width(other.width),
+	height(other.height),
+	precision(other.precision),
+	chunk_shift(other.chunk_shift),
+	chunk_count(other.chunk_count),
+	red(other.red),
+	green(other.green),
+	blue(other.blue),
+	alpha(other.alpha)
 {
-	_mm_free(red);
-	_mm_free(green);
-	_mm_free(blue);
+	other.width = 0;
+	other.height = 0;
+	other.chunk_shift = 0;
+	other.chunk_count = 0;
+	other.red = 0;
+	other.green = 0;
+	other.blue = 0;
+	other.alpha = 0;
+}
 
-	this->width = width;
-	this->height = height;
+Image& Image::operator =(Image&& other)
+{
+	if (this != &other) {
+		releasePlanes();
 
-	const size_t size = static_cast<size_t>(width) * height;
+		width = other.width;
+		height = other.height;
+		precision = other.precision;
+		chunk_shift = other.chunk_shift;
+		chunk_count = other.chunk_count;
+		red = other.red;
+		green = other.green;
+		blue = other.blue;
+		alpha = other.alpha;
+
+		other.width = 0;
+		other.height = 0;
+		other.chunk_shift = 0;
+		other.chunk_count = 0;
+		other.red = 0;
+		other.green = 0;
+		other.blue = 0;
+		other.alpha = 0;
+	}
+	return *this;
+}
 
-	red = reinterpret_cast<float*>(_mm_malloc(size * sizeof(float), 4 * sizeof(float)));
-	green = reinterpret_cast<float*>(_mm_malloc(size * sizeof(float), 4 * sizeof(float)));
-	blue = reinterpret_cast<float*>(_mm_malloc(size * sizeof(float), 4 * sizeof(float)));
+void Image::clearAndInitialize(unsigned int width, unsigned int height, bool zero_fill, Precision precision)
+{
+	if (precision == PRECISION_HALF && !isHalfFloatSupported()) {
+		throw Exception("Half precision planes need a CPU with F16C.", __FILE__, __LINE__);
+	}
 
-	std::fill(red, red + size, 0.0f);
-	std::fill(green, green + size, 0.0f);
-	std::fill(blue, blue + size, 0.0f);
+	if (this->width != width || this->height != height || this->precision != precision) {
+		releasePlanes();
+		this->width = width;
+		this->height = height;
+		this->precision = precision;
+		allocatePlanes();
+	} else {
+		releasePlane(alpha);
+	}
+
+	if (zero_fill) {
+		fillPlane(red, width * getSampleSize(precision), height, chunk_shift);
+		fillPlane(green, width * getSampleSize(precision), height, chunk_shift);
+		fillPlane(blue, width * getSampleSize(precision), height, chunk_shift);
+	}
 }
 
 unsigned int Image::getWidth() const
@@ -132,34 +262,111 @@ unsigned int Image::getHeight() const
 	return height;
 }
 
-float Image::getR(unsigned int x, unsigned int y) const
+Image::Precision Image::getPrecision() const
+{
+	return precision;
+}
+
+const void* Image::getRow(unsigned int channel, unsigned int y) const
+{
+	switch (channel) {
+		case 0: {
+			return red[y];
+		}
+		case 1: {
+			return green[y];
+		}
+		case 3: {
+			return alpha[y];
+		}
+	}
+	return blue[y];
+}
+
+void* Image::getRow(unsigned int channel, unsigned int y)
+{
+	switch (channel) {
+		case 0: {
+			return red[y];
+		}
+		case 1: {
+			return green[y];
+		}
+		case 3: {
+			return alpha[y];
+		}
+	}
+	return blue[y];
+}
+
+void Image::addAlpha()
 {
-	return get(red, width, height, x, y);
+	if (!alpha) {
+		alpha = allocatePlane();
+		fillPlane(alpha, width * getSampleSize(precision), height, chunk_shift);
+	}
 }
 
-float Image::getG(unsigned int x, unsigned int y) const
+bool Image::hasAlpha() const
 {
-	return get(green, width, height, x, y);
+	return alpha != 0;
+}
+
+void Image::copyAlpha(const Image& other)
+{
+	if (!other.alpha || width != other.width || height != other.height) {
+		releasePlane(alpha);
+		return;
+	}
+
+	if (!alpha) {
+		alpha = allocatePlane();
+	}
+
+	if (precision == other.precision) {
+		copyPlane(other.alpha, alpha, width * getSampleSize(precision), height, chunk_shift);
+		countCopy(static_cast<size_t>(width) * height * getSampleSize(precision));
+	} else {
+		for (unsigned int y = 0; y < height; ++y) {
+			for (unsigned int x = 0; x < width; ++x) {
+				setA(x, y, other.getA(x, y));
+			}
+		}
+	}
 }
 
-float Image::getB(unsigned int x, unsigned int y) const
+float Image::getA(unsigned int x, unsigned int y) const
 {
-	return get(blue, width, height, x, y);
+	if (!alpha) {
+		return 65535.0f;
+	}
+	return get(alpha, x, y);
 }
 
-void Image::setR(unsigned int x, unsigned int y, float value)
+void Image::setA(unsigned int x, unsigned int y, float value)
 {
-	set(red, width, height, x, y, value);
+	if (alpha) {
+		set(alpha, x, y, value);
+	}
 }
 
-void Image::setG(unsigned int x, unsigned int y, float value)
+float Image::getConverted(char* const* rows, unsigned int x, unsigned int y) const
 {
-	set(green, width, height, x, y, value);
+	if (x < width && y < height) {
+		const unsigned short sample = reinterpret_cast<const unsigned short*>(rows[y])[x];
+		return precision == PRECISION_HALF ? decodeHalf(sample) : sample;
+	}
+	return 0.0f;
 }
 
-void Image::setB(unsigned int x, unsigned int y, float value)
+void Image::setConverted(char** rows, unsigned int x, unsigned int y, float value)
 {
-	set(blue, width, height, x, y, value);
+	if (x < width && y < height) {
+		reinterpret_cast<unsigned short*>(rows[y])[x] =
+			precision == PRECISION_HALF
+				? encodeHalf(value)
+				: static_cast<unsigned short>(std::max(0.0f, std::min(65535.0f, value)));
+	}
 }
 
 Image::Difference Image::compare(const Image& other) const
@@ -192,3 +399,117 @@ Image::Difference Image::compare(const Image& other) const
 
 	return difference;
 }
+
+Image::Statistics Image::getStatistics()
+{
+	pthread_mutex_lock(&pool_mutex);
+	const Statistics res = statistics;
+	pthread_mutex_unlock(&pool_mutex);
+	return res;
+}
+
+void Image::resetStatistics()
+{
+	pthread_mutex_lock(&pool_mutex);
+	statistics.allocations = 0;
+	statistics.pooled = 0;
+	statistics.bytes_copied = 0;
+	pthread_mutex_unlock(&pool_mutex);
+}
+
+void Image::releasePool()
+{
+	pthread_mutex_lock(&pool_mutex);
+	Pool released;
+	released.swap(pool);
+	pooled_bytes = 0;
+	pthread_mutex_unlock(&pool_mutex);
+
+	for (Pool::const_iterator released_it = released.begin(); released_it != released.end(); ++released_it) {
+		freeMemory(released_it->second);
+	}
+}
+
+void Image::allocatePlanes()
+{
+	chunk_shift = 0;
+	while (
+		(1u << (chunk_shift + 1)) <= height
+		&& (static_cast<size_t>(width) << (chunk_shift + 1)) * getSampleSize(precision) <= max_chunk_bytes
+	) {
+		++chunk_shift;
+	}
+	chunk_count = (static_cast<size_t>(height) + (1u << chunk_shift) - 1) >> chunk_shift;
+
+	try {
+		red = allocatePlane();
+		green = allocatePlane();
+		blue = allocatePlane();
+	}
+	catch (...) {
+		releasePlanes();
+		width = 0;
+		height = 0;
+		throw;
+	}
+}
+
+void Image::releasePlanes()
+{
+	releasePlane(red);
+	releasePlane(green);
+	releasePlane(blue);
+	releasePlane(alpha);
+	chunk_count = 0;
+}
+
+char** Image::allocatePlane()
+{
+	if (!chunk_count) {
+		return 0;
+	}
+
+	const size_t row_size = width * getSampleSize(precision);
+
+	char** const rows = new char*[height];
+	size_t chunk = 0;
+	try {
+		for (; chunk < chunk_count; ++chunk) {
+			const size_t first_row = chunk << chunk_shift;
+			char* const rows_chunk = acquireChunk(getChunkSize(chunk));
+			for (size_t row = first_row; row < std::min<size_t>(height, first_row + (1u << chunk_shift)); ++row) {
+				rows[row] = rows_chunk + (row - first_row) * row_size;
+			}
+		}
+	}
+	catch (...) {
+		while (chunk) {
+			--chunk;
+			releaseChunk(rows[chunk << chunk_shift], getChunkSize(chunk));
+		}
+		delete[] rows;
+		throw;
+	}
+	return rows;
+}
+
+void Image::releasePlane(char**& rows)
+{
+	if (!rows) {
+		return;
+	}
+
+	for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+		releaseChunk(rows[chunk << chunk_shift], getChunkSize(chunk));
+	}
+
+	delete[] rows;
+	rows = 0;
+}
+
+size_t Image::getChunkSize(size_t chunk) const
+{
+	const unsigned int rows_per_chunk = 1u << chunk_shift;
+	const size_t first_row = chunk << chunk_shift;
+	return static_cast<size_t>(width) * getSampleSize(precision) * std::min<size_t>(rows_per_chunk, height - first_row);
+}
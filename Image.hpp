@@ -22,9 +22,20 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+
+// The planes are stored in chunks of whole rows, so huge images need no contiguous address range
 class Image
 {
 public:
+	// Half planes take half the bandwidth, see HalfFloat.hpp, 16b planes hold the samples as they are on disk
+	enum Precision {
+		PRECISION_FLOAT,
+		PRECISION_HALF,
+		PRECISION_U16
+	};
+
 	struct Difference {
 		unsigned long long absolute;
 		unsigned int max_r;
@@ -32,32 +43,134 @@ public:
 		unsigned int max_b;
 	};
 
+	// Plane chunks taken from the system or the pool and bytes deep-copied between images
+	struct Statistics {
+		unsigned long long allocations;
+		unsigned long long pooled;
+		unsigned long long bytes_copied;
+	};
+
 	Image();
 	~Image();
 
 	Image(const Image& other);
 	Image& operator =(const Image& other);
 
-	void clearAndInitialize(unsigned int width, unsigned int height);
+	Image(Image&& other);
+	Image& operator =(Image&& other);
+
+	// Skip zero-filling only if every pixel is set afterwards
+	void clearAndInitialize(unsigned int width, unsigned int height, bool zero_fill = true, Precision precision = PRECISION_FLOAT);
 
 	unsigned int getWidth() const;
 	unsigned int getHeight() const;
+	Precision getPrecision() const;
+
+	// Optional plane passed through untouched by the conversions, removed by clearAndInitialize()
+	void addAlpha();
+	bool hasAlpha() const;
+	// Takes over the alpha plane (or its absence) of an image of the same size
+	void copyAlpha(const Image& other);
+
+	// Raw samples of a channel (0 red, 1 green, 2 blue, 3 alpha), float, half or unsigned short depending on the precision
+	const void* getRow(unsigned int channel, unsigned int y) const;
+	void* getRow(unsigned int channel, unsigned int y);
 
 	float getR(unsigned int x, unsigned int y) const;
 	float getG(unsigned int x, unsigned int y) const;
 	float getB(unsigned int x, unsigned int y) const;
+	// Opaque without alpha plane
+	float getA(unsigned int x, unsigned int y) const;
 
 	void setR(unsigned int x, unsigned int y, float value);
 	void setG(unsigned int x, unsigned int y, float value);
 	void setB(unsigned int x, unsigned int y, float value);
+	// Ignored without alpha plane
+	void setA(unsigned int x, unsigned int y, float value);
 
 	Difference compare(const Image& other) const;
 
+	static Statistics getStatistics();
+	static void resetStatistics();
+	// Frees the plane chunks of destroyed images kept for reuse
+	static void releasePool();
+
 private:
+	// Float planes inline with a single, loop invariant precision test, the
+	// other precisions out of line
+	float get(char* const* rows, unsigned int x, unsigned int y) const;
+	void set(char** rows, unsigned int x, unsigned int y, float value);
+	float getConverted(char* const* rows, unsigned int x, unsigned int y) const;
+	void setConverted(char** rows, unsigned int x, unsigned int y, float value);
+
+	void allocatePlanes();
+	void releasePlanes();
+	char** allocatePlane();
+	void releasePlane(char**& rows);
+	// In bytes
+	size_t getChunkSize(size_t chunk) const;
+
 	unsigned int width;
 	unsigned int height;
+	Precision precision;
 
-	float* red;
-	float* green;
-	float* blue;
+	// Rows per chunk are a power of two
+	unsigned int chunk_shift;
+	size_t chunk_count;
+
+	// Row pointers into the chunks
+	char** red;
+	char** green;
+	char** blue;
+	char** alpha;
 };
+
+inline float Image::getR(unsigned int x, unsigned int y) const
+{
+	return get(red, x, y);
+}
+
+inline float Image::getG(unsigned int x, unsigned int y) const
+{
+	return get(green, x, y);
+}
+
+inline float Image::getB(unsigned int x, unsigned int y) const
+{
+	return get(blue, x, y);
+}
+
+inline void Image::setR(unsigned int x, unsigned int y, float value)
+{
+	set(red, x, y, value);
+}
+
+inline void Image::setG(unsigned int x, unsigned int y, float value)
+{
+	set(green, x, y, value);
+}
+
+inline void Image::setB(unsigned int x, unsigned int y, float value)
+{
+	set(blue, x, y, value);
+}
+
+inline float Image::get(char* const* rows, unsigned int x, unsigned int y) const
+{
+	if (precision != PRECISION_FLOAT) {
+		return getConverted(rows, x, y);
+	}
+	if (x < width && y < height) {
+		return reinterpret_cast<const float*>(rows[y])[x];
+	}
+	return 0.0f;
+}
+
+inline void Image::set(char** rows, unsigned int x, unsigned int y, float value)
+{
+	if (precision != PRECISION_FLOAT) {
+		setConverted(rows, x, y, value);
+	} else if (x < width && y < height) {
+		reinterpret_cast<float*>(rows[y])[x] = std::max(0.0f, std::min(65535.0f, value));
+	}
+}
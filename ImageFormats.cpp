@@ -0,0 +1,123 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <fstream>
+
+#include "ImageFormats.hpp"
+
+#include "Exception.hpp"
+#include "PamImageReader.hpp"
+#include "PamImageWriter.hpp"
+#include "PfmImageReader.hpp"
+#include "PfmImageWriter.hpp"
+#include "PpmImageReader.hpp"
+#include "PpmImageWriter.hpp"
+
+void loadImage(const std::string& path, Image& image, Image::Precision precision)
+{
+	std::ifstream file(path.c_str(), std::ios::binary);
+	if (!file) {
+		throw Exception("Can't open image.", __FILE__, __LINE__);
+	}
+
+	char magic[2];
+	if (!file.read(magic, sizeof(magic)) || magic[0] != 'P') {
+		throw Exception("Unknown image format.", __FILE__, __LINE__);
+	}
+	file.seekg(0);
+
+	switch (magic[1]) {
+		case '6': {
+			PpmImageReader(precision).load(file, image);
+			break;
+		}
+
+		case '7': {
+			PamImageReader(precision).load(file, image);
+			break;
+		}
+
+		case 'F': {
+			file.close();
+			PfmImageReader(precision).loadFile(path, image);
+			break;
+		}
+
+		default: {
+			throw Exception("Unknown image format.", __FILE__, __LINE__);
+		}
+	}
+}
+
+void loadImage(std::istream& stream, Image& image, Image::Precision precision)
+{
+	const int first = stream.get();
+	const int second = stream.peek();
+	stream.unget();
+	if (first != 'P' || !stream) {
+		throw Exception("Unknown image format.", __FILE__, __LINE__);
+	}
+
+	switch (second) {
+		case '6': {
+			PpmImageReader(precision).load(stream, image);
+			break;
+		}
+
+		case '7': {
+			PamImageReader(precision).load(stream, image);
+			break;
+		}
+
+		case 'F': {
+			PfmImageReader(precision).load(stream, image);
+			break;
+		}
+
+		default: {
+			throw Exception("Unknown image format.", __FILE__, __LINE__);
+		}
+	}
+}
+
+void saveImage(const Image& image, const std::string& path)
+{
+	const std::string extension = getImageExtension(path);
+	std::ofstream file(path.c_str(), std::ios::binary);
+
+	if (extension == ".pfm") {
+		PfmImageWriter().save(image, file);
+	} else if (extension == ".pam") {
+		PamImageWriter().save(image, file);
+	} else {
+		PpmImageWriter().save(image, file);
+	}
+}
+
+std::string getImageExtension(const std::string& path)
+{
+	const std::string::size_type dot = path.rfind('.');
+	if (dot == std::string::npos || path.find('/', dot) != std::string::npos) {
+		return std::string();
+	}
+	return path.substr(dot);
+}
@@ -0,0 +1,37 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#pragma once
+
+#include <iosfwd>
+#include <string>
+
+#include "Image.hpp"
+
+// Picks the reader by the magic number: P6 (PPM), P7 (PAM) or PF (PFM, mapped)
+void loadImage(const std::string& path, Image& image, Image::Precision precision = Image::PRECISION_FLOAT);
+// Same from a stream, PFM is read row by row
+void loadImage(std::istream& stream, Image& image, Image::Precision precision = Image::PRECISION_FLOAT);
+// Picks the writer by the extension: .pfm, .pam or PPM for anything else
+void saveImage(const Image& image, const std::string& path);
+// Extension of the path including the dot, empty if there is none
+std::string getImageExtension(const std::string& path);
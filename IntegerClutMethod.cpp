@@ -22,10 +22,10 @@
 
 #include <algorithm>
 
-#include <xmmintrin.h>
-
 #include "IntegerClutMethod.hpp"
 
+#include "Memory.hpp"
+
 namespace
 {
 
@@ -38,13 +38,16 @@ namespace
 }
 
 IntegerClutMethod::IntegerClutMethod() :
-	clut_image(0)
+	clut_storage(0),
+	clut_image(0),
+	clut_level(0),
+	strength(1.0f)
 {
 }
 
 IntegerClutMethod::~IntegerClutMethod()
 {
-	_mm_free(clut_image);
+	freeMemory(clut_storage);
 }
 
 const char* IntegerClutMethod::getDescription() const
@@ -59,27 +62,43 @@ const char* IntegerClutMethod::getFilename() const
 
 void IntegerClutMethod::setClut(const Image& image, unsigned int level)
 {
-	_mm_free(clut_image);
-	const size_t size = image.getWidth() * image.getHeight();
-	clut_image = reinterpret_cast<unsigned short*>(_mm_malloc(size * 4 * sizeof(unsigned short), 4 * sizeof(unsigned short)));
+	freeMemory(clut_storage);
+	const size_t size = static_cast<size_t>(image.getWidth()) * image.getHeight();
+	clut_storage = reinterpret_cast<unsigned short*>(allocateMemory(size * 4 * sizeof(unsigned short), 4 * sizeof(unsigned short)));
 	size_t index = 0;
 	for (unsigned int y = 0; y < image.getHeight(); ++y) {
 		for (unsigned int x = 0; x < image.getWidth(); ++x) {
-			clut_image[index] = image.getR(x, y);
+			clut_storage[index] = image.getR(x, y);
 			++index;
-			clut_image[index] = image.getG(x, y);
+			clut_storage[index] = image.getG(x, y);
 			++index;
-			clut_image[index] = image.getB(x, y);
+			clut_storage[index] = image.getB(x, y);
 			index += 2;
 		}
 	}
 
+	clut_image = clut_storage;
+
 	clut_level = level * level;
 	flevel_minus_one = static_cast<float>(clut_level - 1) / 65535.0f;
 	flevel_minus_two = static_cast<float>(clut_level - 2);
 }
 
-void IntegerClutMethod::convert(float* rgb) const
+bool IntegerClutMethod::setPackedClut(const unsigned short* packed_clut, unsigned int level)
+{
+	freeMemory(clut_storage);
+	clut_storage = 0;
+
+	clut_image = packed_clut;
+
+	clut_level = level * level;
+	flevel_minus_one = static_cast<float>(clut_level - 1) / 65535.0f;
+	flevel_minus_two = static_cast<float>(clut_level - 2);
+
+	return true;
+}
+
+inline void IntegerClutMethod::locate(const float* rgb, ClutCell& cell) const
 {
 	const unsigned int level = clut_level; // This is important
 
@@ -87,13 +106,23 @@ void IntegerClutMethod::convert(float* rgb) const
 	const unsigned int green = std::min(flevel_minus_two, rgb[1] * flevel_minus_one);
 	const unsigned int blue = std::min(flevel_minus_two, rgb[2] * flevel_minus_one);
 
-	const float r = rgb[0] * flevel_minus_one - red;
-	const float g = rgb[1] * flevel_minus_one - green;
-	const float b = rgb[2] * flevel_minus_one - blue;
+	cell.fraction[0] = rgb[0] * flevel_minus_one - red;
+	cell.fraction[1] = rgb[1] * flevel_minus_one - green;
+	cell.fraction[2] = rgb[2] * flevel_minus_one - blue;
 
+	cell.color = red + green * level + blue * level * level;
+}
+
+inline void IntegerClutMethod::interpolate(const ClutCell& cell, float* rgb) const
+{
+	const unsigned int level = clut_level; // This is important
 	const unsigned int level_square = level * level;
 
-	const unsigned int color = red + green * level + blue * level_square;
+	const float r = cell.fraction[0];
+	const float g = cell.fraction[1];
+	const float b = cell.fraction[2];
+
+	const unsigned int color = cell.color;
 
 	size_t index[2];
 	posToIndex(color, index);
@@ -131,7 +160,48 @@ void IntegerClutMethod::convert(float* rgb) const
 	tmp1[1] = tmp1[1] * (1 - g) + tmp2[1] * g;
 	tmp1[2] = tmp1[2] * (1 - g) + tmp2[2] * g;
 
-	rgb[0] = out[0] * (1 - b) + tmp1[0] * b;
-	rgb[1] = out[1] * (1 - b) + tmp1[1] * b;
-	rgb[2] = out[2] * (1 - b) + tmp1[2] * b;
+	out[0] = out[0] * (1 - b) + tmp1[0] * b;
+	out[1] = out[1] * (1 - b) + tmp1[1] * b;
+	out[2] = out[2] * (1 - b) + tmp1[2] * b;
+
+	if (strength != 1.0f) {
+		rgb[0] += strength * (out[0] - rgb[0]);
+		rgb[1] += strength * (out[1] - rgb[1]);
+		rgb[2] += strength * (out[2] - rgb[2]);
+	} else {
+		rgb[0] = out[0];
+		rgb[1] = out[1];
+		rgb[2] = out[2];
+	}
+}
+
+void IntegerClutMethod::convert(float* rgb) const
+{
+	ClutCell cell;
+	locate(rgb, cell);
+	interpolate(cell, rgb);
+}
+
+bool IntegerClutMethod::locateCell(const float* rgb, ClutCell& cell) const
+{
+	locate(rgb, cell);
+	return true;
+}
+
+void IntegerClutMethod::interpolateCell(const ClutCell& cell, float* rgb) const
+{
+	interpolate(cell, rgb);
+}
+
+void IntegerClutMethod::setStrength(float _strength)
+{
+	strength = _strength;
+}
+
+size_t IntegerClutMethod::getClutFootprint() const
+{
+	if (!clut_image) {
+		return 0;
+	}
+	return static_cast<size_t>(clut_level) * clut_level * clut_level * 4 * sizeof(unsigned short);
 }
@@ -36,11 +36,24 @@ public:
 	const char* getFilename() const;
 
 	void setClut(const Image& image, unsigned int level);
+	bool setPackedClut(const unsigned short* packed_clut, unsigned int level);
 	void convert(float* rgb) const;
+	void setStrength(float _strength);
+
+	size_t getClutFootprint() const;
+
+	bool locateCell(const float* rgb, ClutCell& cell) const;
+	void interpolateCell(const ClutCell& cell, float* rgb) const;
 
 private:
-	unsigned short* clut_image;
+	// Inlined so convert() does not pay for the split
+	void locate(const float* rgb, ClutCell& cell) const __attribute__((always_inline));
+	void interpolate(const ClutCell& cell, float* rgb) const __attribute__((always_inline));
+
+	unsigned short* clut_storage;
+	const unsigned short* clut_image;
 	unsigned int clut_level;
 	float flevel_minus_one;
 	float flevel_minus_two;
+	float strength;
 };
@@ -0,0 +1,171 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "KernelSelection.hpp"
+
+#include "CacheFiles.hpp"
+#include "ClutMethod.hpp"
+#include "ClutMethods.hpp"
+#include "Conversion.hpp"
+#include "Exception.hpp"
+#include "Image.hpp"
+#include "SystemInfo.hpp"
+#include "Timer.hpp"
+
+namespace
+{
+
+	unsigned int getMaxError(const Image& reference_image, const Image& image)
+	{
+		const Image::Difference difference = reference_image.compare(image);
+		return std::max(difference.max_r, std::max(difference.max_g, difference.max_b));
+	}
+
+}
+
+std::vector<KernelMeasurement> measureKernels(const Image& calibration_image, const Image& clut_image, unsigned int level, unsigned int cycles)
+{
+	const std::vector<ClutMethod*> clut_methods = createAllClutMethods();
+	std::vector<KernelMeasurement> measurements;
+
+	try {
+		Image reference_image;
+		Image output_image;
+
+		for (std::vector<ClutMethod*>::const_iterator clut_methods_it = clut_methods.begin(); clut_methods_it != clut_methods.end(); ++clut_methods_it) {
+			KernelMeasurement measurement;
+			measurement.name = (*clut_methods_it)->getFilename();
+			measurement.nsecs = 0;
+
+			for (unsigned int cycle = 0; cycle < std::max(cycles, 1u); ++cycle) {
+				(*clut_methods_it)->setClut(clut_image, level);
+
+				Timer timer;
+				convertRows(**clut_methods_it, calibration_image, output_image);
+				timer.stop();
+
+				if (!cycle || timer.getNSecs() < measurement.nsecs) {
+					measurement.nsecs = timer.getNSecs();
+				}
+			}
+
+			if (clut_methods_it == clut_methods.begin()) {
+				reference_image = output_image;
+				measurement.max_error = 0;
+			} else {
+				measurement.max_error = getMaxError(reference_image, output_image);
+			}
+
+			measurements.push_back(measurement);
+		}
+	}
+	catch (...) {
+		destroyClutMethods(clut_methods);
+		throw;
+	}
+
+	destroyClutMethods(clut_methods);
+	return measurements;
+}
+
+const KernelMeasurement& selectKernel(const std::vector<KernelMeasurement>& measurements, unsigned int tolerance)
+{
+	if (measurements.empty()) {
+		throw Exception("No kernels measured.", __FILE__, __LINE__);
+	}
+
+	std::vector<KernelMeasurement>::const_iterator best = measurements.begin();
+	for (std::vector<KernelMeasurement>::const_iterator measurements_it = measurements.begin() + 1; measurements_it != measurements.end(); ++measurements_it) {
+		if (measurements_it->max_error <= tolerance && measurements_it->nsecs < best->nsecs) {
+			best = measurements_it;
+		}
+	}
+	return *best;
+}
+
+KernelChoices::KernelChoices(const std::string& _path) :
+	path(_path)
+{
+	std::ifstream file(path.c_str());
+	std::string line;
+	while (std::getline(file, line)) {
+		std::istringstream stream(line);
+		Choice choice;
+		if (stream >> choice.level >> choice.tolerance >> choice.kernel) {
+			stream >> std::ws;
+			std::getline(stream, choice.machine);
+			choices.push_back(choice);
+		}
+	}
+}
+
+bool KernelChoices::find(const std::string& machine, unsigned int level, unsigned int tolerance, std::string& kernel) const
+{
+	for (std::vector<Choice>::const_iterator choices_it = choices.begin(); choices_it != choices.end(); ++choices_it) {
+		if (choices_it->machine == machine && choices_it->level == level && choices_it->tolerance == tolerance) {
+			kernel = choices_it->kernel;
+			return true;
+		}
+	}
+	return false;
+}
+
+void KernelChoices::set(const std::string& machine, unsigned int level, unsigned int tolerance, const std::string& kernel)
+{
+	for (std::vector<Choice>::iterator choices_it = choices.begin(); choices_it != choices.end(); ++choices_it) {
+		if (choices_it->machine == machine && choices_it->level == level && choices_it->tolerance == tolerance) {
+			choices_it->kernel = kernel;
+			return;
+		}
+	}
+
+	Choice choice;
+	choice.machine = machine;
+	choice.level = level;
+	choice.tolerance = tolerance;
+	choice.kernel = kernel;
+	choices.push_back(choice);
+}
+
+void KernelChoices::save() const
+{
+	std::ostringstream contents;
+	for (std::vector<Choice>::const_iterator choices_it = choices.begin(); choices_it != choices.end(); ++choices_it) {
+		contents << choices_it->level << ' ' << choices_it->tolerance << ' ' << choices_it->kernel << ' ' << choices_it->machine << '\n';
+	}
+	writeCacheFile(path, contents.str());
+}
+
+std::string KernelChoices::getMachine()
+{
+	const std::string cpu_model = SystemInfo().getCpuModel();
+	return cpu_model.empty() ? "unknown" : cpu_model;
+}
+
+std::string KernelChoices::getDefaultPath()
+{
+	return getCachePath("kernels");
+}
@@ -0,0 +1,78 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+class Image;
+
+struct KernelMeasurement {
+	// ClutMethod::getFilename()
+	std::string name;
+	// Fastest of the cycles
+	unsigned long long nsecs;
+	// Largest channel difference to the original method's output
+	unsigned int max_error;
+};
+
+// Converts the calibration image cycles times with every method of
+// createAllClutMethods() through convertRows(), setting the CLUT up again
+// before each cycle so caching methods start cold. The original method comes
+// first and is the error reference.
+std::vector<KernelMeasurement> measureKernels(const Image& calibration_image, const Image& clut_image, unsigned int level, unsigned int cycles);
+
+// Fastest measurement with an error of at most tolerance (in 0..65535),
+// the original method always qualifies
+const KernelMeasurement& selectKernel(const std::vector<KernelMeasurement>& measurements, unsigned int tolerance);
+
+// Selected kernels per machine, CLUT level and tolerance, kept in a text
+// file with one "LEVEL TOLERANCE KERNEL MACHINE" line per choice
+class KernelChoices
+{
+public:
+	// Loads the file if it exists
+	explicit KernelChoices(const std::string& _path);
+
+	bool find(const std::string& machine, unsigned int level, unsigned int tolerance, std::string& kernel) const;
+	void set(const std::string& machine, unsigned int level, unsigned int tolerance, const std::string& kernel);
+
+	// Creates missing directories and replaces the file atomically
+	void save() const;
+
+	// CPU model, as the kernels' relative speed depends on it
+	static std::string getMachine();
+	// getCachePath("kernels")
+	static std::string getDefaultPath();
+
+private:
+	struct Choice {
+		std::string machine;
+		unsigned int level;
+		unsigned int tolerance;
+		std::string kernel;
+	};
+
+	const std::string path;
+	std::vector<Choice> choices;
+};
@@ -0,0 +1,273 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <x86intrin.h>
+
+#include "LatencyBenchMode.hpp"
+
+#include "Arguments.hpp"
+#include "ClutMethod.hpp"
+#include "ClutMethods.hpp"
+#include "Exception.hpp"
+#include "HaldClut.hpp"
+#include "Image.hpp"
+#include "ImageFormats.hpp"
+#include "Timer.hpp"
+
+namespace
+{
+
+	enum Stream {
+		STREAM_REPEATED,
+		STREAM_ADJACENT,
+		STREAM_RANDOM,
+		STREAM_COUNT
+	};
+
+	const char* const stream_names[STREAM_COUNT] = {
+		"repeated",
+		"adjacent",
+		"random"
+	};
+
+	// Histogram buckets by powers of two, the last one is open
+	const unsigned int bucket_count = 16;
+
+	inline unsigned long long startCycles()
+	{
+		_mm_lfence();
+		return __rdtsc();
+	}
+
+	inline unsigned long long stopCycles()
+	{
+		unsigned int aux;
+		const unsigned long long cycles = __rdtscp(&aux);
+		_mm_lfence();
+		return cycles;
+	}
+
+	// Four floats per pixel, copied to an aligned buffer before each call
+	void createStream(Stream stream, unsigned int level, unsigned int samples, std::vector<float>& pixels)
+	{
+		pixels.resize(samples * 4);
+
+		const unsigned int cells = level * level;
+		const float cell_size = 65535.0f / (cells - 1);
+		unsigned int seed = 1;
+
+		for (unsigned int sample = 0; sample < samples; ++sample) {
+			float* const pixel = &pixels[sample * 4];
+			switch (stream) {
+				case STREAM_REPEATED: {
+					pixel[0] = 0.37f * 65535.0f;
+					pixel[1] = 0.52f * 65535.0f;
+					pixel[2] = 0.61f * 65535.0f;
+					break;
+				}
+
+				case STREAM_ADJACENT: {
+					// Red steps one cell per call, carrying into green and blue
+					const unsigned int cell = sample % (cells * cells * cells);
+					pixel[0] = (cell % cells) * cell_size;
+					pixel[1] = (cell / cells % cells) * cell_size;
+					pixel[2] = (cell / (cells * cells)) * cell_size;
+					for (unsigned int channel = 0; channel < 3; ++channel) {
+						pixel[channel] = std::min(pixel[channel] + 0.37f * cell_size, 65535.0f);
+					}
+					break;
+				}
+
+				case STREAM_RANDOM:
+				case STREAM_COUNT: {
+					for (unsigned int channel = 0; channel < 3; ++channel) {
+						seed = seed * 1103515245 + 12345;
+						pixel[channel] = (seed >> 8) & 0xFFFF;
+					}
+					break;
+				}
+			}
+			pixel[3] = 0.0f;
+		}
+	}
+
+	unsigned long long getTimerOverhead()
+	{
+		unsigned long long overhead = ~0ull;
+		for (unsigned int run = 0; run < 1000; ++run) {
+			const unsigned long long start = startCycles();
+			overhead = std::min(overhead, stopCycles() - start);
+		}
+		return overhead;
+	}
+
+	double getTscFrequency()
+	{
+		Timer timer;
+		const unsigned long long start = __rdtsc();
+		do {
+			timer.stop();
+		} while (timer.getMSecs() < 20);
+		return static_cast<double>(__rdtsc() - start) / timer.getNSecs();
+	}
+
+	// Samples the per-call cycles of convert(), sorted
+	void measureStream(const ClutMethod& clut_method, const std::vector<float>& pixels, unsigned int samples, unsigned long long overhead, std::vector<unsigned long long>& cycles)
+	{
+		cycles.resize(samples);
+		float rgb[4] __attribute__((aligned(16)));
+
+		for (unsigned int sample = 0; sample < samples; ++sample) {
+			std::copy(pixels.begin() + sample * 4, pixels.begin() + sample * 4 + 4, rgb);
+
+			const unsigned long long start = startCycles();
+			clut_method.convert(rgb);
+			const unsigned long long elapsed = stopCycles() - start;
+
+			cycles[sample] = elapsed > overhead ? elapsed - overhead : 0;
+		}
+
+		std::sort(cycles.begin(), cycles.end());
+	}
+
+	unsigned int getBucket(unsigned long long cycles)
+	{
+		unsigned int bucket = 0;
+		while (bucket < bucket_count - 1 && cycles >= (2ull << bucket)) {
+			++bucket;
+		}
+		return bucket;
+	}
+
+	unsigned long long getPercentile(const std::vector<unsigned long long>& sorted_cycles, double percentile)
+	{
+		return sorted_cycles[std::min<size_t>(sorted_cycles.size() * percentile / 100.0, sorted_cycles.size() - 1)];
+	}
+
+}
+
+const char* LatencyBenchMode::getName() const
+{
+	return "--latency";
+}
+
+const char* LatencyBenchMode::getUsage() const
+{
+	return "CLUT [SAMPLES]";
+}
+
+unsigned int LatencyBenchMode::getMinimumArgumentCount() const
+{
+	return 1;
+}
+
+void LatencyBenchMode::run(const std::vector<std::string>& args)
+{
+	Image clut_image;
+	loadImage(args[0], clut_image);
+
+	const unsigned int level = getHaldClutLevel(clut_image);
+	if (level < 2) {
+		throw Exception("CLUT image has wrong dimensions.", __FILE__, __LINE__);
+	}
+
+	unsigned int samples = 100000;
+	if (args.size() > 1) {
+		samples = getNumber(args[1]);
+	}
+	if (!samples) {
+		throw Exception("At least one sample is needed.", __FILE__, __LINE__);
+	}
+
+	std::vector<float> stream_pixels[STREAM_COUNT];
+	for (unsigned int stream = 0; stream < STREAM_COUNT; ++stream) {
+		createStream(static_cast<Stream>(stream), level, samples, stream_pixels[stream]);
+	}
+
+	const unsigned long long overhead = getTimerOverhead();
+	std::cout << "TSC:        " << getTscFrequency() << " GHz, " << overhead << " cycles timer overhead subtracted" << std::endl;
+	std::cout << "Samples:    " << samples << " calls per stream" << std::endl;
+
+	const std::vector<ClutMethod*> clut_methods = createAllClutMethods();
+
+	try {
+		std::vector<unsigned long long> cycles[STREAM_COUNT];
+
+		for (std::vector<ClutMethod*>::const_iterator clut_methods_it = clut_methods.begin(); clut_methods_it != clut_methods.end(); ++clut_methods_it) {
+			const ClutMethod& clut_method = **clut_methods_it;
+			(*clut_methods_it)->setClut(clut_image, level);
+
+			unsigned int histograms[STREAM_COUNT][bucket_count] = {};
+			for (unsigned int stream = 0; stream < STREAM_COUNT; ++stream) {
+				measureStream(clut_method, stream_pixels[stream], samples, overhead, cycles[stream]);
+				for (std::vector<unsigned long long>::const_iterator cycles_it = cycles[stream].begin(); cycles_it != cycles[stream].end(); ++cycles_it) {
+					++histograms[stream][getBucket(*cycles_it)];
+				}
+			}
+
+			std::cout << std::endl << clut_method.getFilename() << " (" << clut_method.getClutFootprint() << " B CLUT)" << std::endl;
+			std::cout << "  cycles   ";
+			for (unsigned int stream = 0; stream < STREAM_COUNT; ++stream) {
+				std::cout << std::setw(10) << stream_names[stream];
+			}
+			std::cout << std::endl;
+
+			for (unsigned int bucket = 0; bucket < bucket_count; ++bucket) {
+				if (!histograms[STREAM_REPEATED][bucket] && !histograms[STREAM_ADJACENT][bucket] && !histograms[STREAM_RANDOM][bucket]) {
+					continue;
+				}
+
+				std::cout << "  " << (bucket < bucket_count - 1 ? "< " : ">=") << std::setw(7) << (bucket < bucket_count - 1 ? 2ull << bucket : 1ull << bucket);
+				for (unsigned int stream = 0; stream < STREAM_COUNT; ++stream) {
+					std::cout << std::setw(9) << std::fixed << std::setprecision(2) << 100.0 * histograms[stream][bucket] / samples << '%';
+				}
+				std::cout << std::endl;
+			}
+
+			const double percentiles[] = {50.0, 90.0, 99.0, 99.9};
+			const char* const percentile_names[] = {"p50", "p90", "p99", "p99.9"};
+			for (unsigned int percentile = 0; percentile < 4; ++percentile) {
+				std::cout << "  " << std::left << std::setw(9) << percentile_names[percentile] << std::right;
+				for (unsigned int stream = 0; stream < STREAM_COUNT; ++stream) {
+					std::cout << std::setw(10) << getPercentile(cycles[stream], percentiles[percentile]);
+				}
+				std::cout << std::endl;
+			}
+			std::cout << "  max      ";
+			for (unsigned int stream = 0; stream < STREAM_COUNT; ++stream) {
+				std::cout << std::setw(10) << cycles[stream].back();
+			}
+			std::cout << std::endl;
+		}
+	}
+	catch (...) {
+		destroyClutMethods(clut_methods);
+		throw;
+	}
+
+	destroyClutMethods(clut_methods);
+}
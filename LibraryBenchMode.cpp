@@ -0,0 +1,249 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "LibraryBenchMode.hpp"
+
+#include "clut.h"
+
+#include "Arguments.hpp"
+#include "Exception.hpp"
+#include "Image.hpp"
+#include "PpmImageReader.hpp"
+#include "PpmImageWriter.hpp"
+#include "Timer.hpp"
+
+namespace
+{
+
+	void check(clut_status status)
+	{
+		if (status != CLUT_OK) {
+			throw Exception(clut_get_status_message(status), __FILE__, __LINE__);
+		}
+	}
+
+	std::string getExecutablePath()
+	{
+		char path[4096];
+		const ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+		if (length <= 0) {
+			throw Exception("Can't find the clutbench executable.", __FILE__, __LINE__);
+		}
+		return std::string(path, length);
+	}
+
+	// Runs clutbench --apply like a service shelling out would, returns false on failure
+	bool runApply(const std::string& executable, const std::string& input_path, const std::string& clut_path, const std::string& output_path, const std::string& kernel, const std::string& threads)
+	{
+		const pid_t pid = fork();
+		if (pid < 0) {
+			return false;
+		}
+		if (!pid) {
+			execl(
+				executable.c_str(),
+				executable.c_str(),
+				"--apply",
+				input_path.c_str(),
+				clut_path.c_str(),
+				output_path.c_str(),
+				kernel.c_str(),
+				threads.c_str(),
+				static_cast<char*>(0)
+			);
+			_exit(127);
+		}
+
+		int status;
+		return waitpid(pid, &status, 0) == pid && WIFEXITED(status) && !WEXITSTATUS(status);
+	}
+
+	void packImage(const Image& image, std::vector<unsigned short>& pixels)
+	{
+		const unsigned int width = image.getWidth();
+		pixels.resize(static_cast<size_t>(width) * image.getHeight() * 3);
+		for (unsigned int y = 0; y < image.getHeight(); ++y) {
+			for (unsigned int channel = 0; channel < 3; ++channel) {
+				const unsigned short* const row = static_cast<const unsigned short*>(image.getRow(channel, y));
+				for (unsigned int x = 0; x < width; ++x) {
+					pixels[(static_cast<size_t>(y) * width + x) * 3 + channel] = row[x];
+				}
+			}
+		}
+	}
+
+	void unpackImage(const std::vector<unsigned short>& pixels, Image& image)
+	{
+		const unsigned int width = image.getWidth();
+		for (unsigned int y = 0; y < image.getHeight(); ++y) {
+			for (unsigned int channel = 0; channel < 3; ++channel) {
+				unsigned short* const row = static_cast<unsigned short*>(image.getRow(channel, y));
+				for (unsigned int x = 0; x < width; ++x) {
+					row[x] = pixels[(static_cast<size_t>(y) * width + x) * 3 + channel];
+				}
+			}
+		}
+	}
+
+}
+
+const char* LibraryBenchMode::getName() const
+{
+	return "--library";
+}
+
+const char* LibraryBenchMode::getUsage() const
+{
+	return "INPUT CLUT [CYCLES] [THREADS]";
+}
+
+unsigned int LibraryBenchMode::getMinimumArgumentCount() const
+{
+	return 2;
+}
+
+void LibraryBenchMode::run(const std::vector<std::string>& args)
+{
+	std::ifstream input_file(args[0].c_str());
+	Image input_image;
+	PpmImageReader(Image::PRECISION_U16).load(input_file, input_image);
+	if (!input_image.getWidth() || !input_image.getHeight()) {
+		throw Exception("Empty input image.", __FILE__, __LINE__);
+	}
+
+	std::ifstream clut_file(args[1].c_str(), std::ios::binary);
+	const std::vector<char> clut_data((std::istreambuf_iterator<char>(clut_file)), std::istreambuf_iterator<char>());
+
+	unsigned int cycles = 10;
+	if (args.size() > 2) {
+		cycles = std::max(1u, getNumber(args[2]));
+	}
+
+	std::string threads = "1";
+	if (args.size() > 3) {
+		threads = args[3];
+	}
+
+	const unsigned int width = input_image.getWidth();
+	const unsigned int height = input_image.getHeight();
+	const size_t stride = width * 3 * sizeof(unsigned short);
+
+	std::vector<unsigned short> input_pixels;
+	packImage(input_image, input_pixels);
+	std::vector<unsigned short> output_pixels(input_pixels.size());
+
+	Timer create_timer;
+	clut_t* clut;
+	check(clut_create_from_memory(clut_data.empty() ? 0 : &clut_data[0], clut_data.size(), &clut));
+	create_timer.stop();
+
+	// Measured once per machine and level, so it is not part of the timings
+	const char* const best_kernel = clut_get_best_kernel(clut, CLUT_PIXEL_RGB16);
+	const std::string kernel = best_kernel ? best_kernel : clut_get_kernel(clut);
+	Timer library_timer;
+	try {
+		check(clut_set_kernel(clut, kernel.c_str()));
+		library_timer.start();
+		for (unsigned int cycle = 0; cycle < cycles; ++cycle) {
+			check(clut_apply(clut, &input_pixels[0], stride, &output_pixels[0], stride, width, height, CLUT_PIXEL_RGB16, getNumber(threads)));
+		}
+		library_timer.stop();
+	}
+	catch (...) {
+		clut_destroy(clut);
+		throw;
+	}
+	clut_destroy(clut);
+
+	// Through files and a process per call
+	char directory_template[] = "/tmp/clutbench-XXXXXX";
+	if (!mkdtemp(directory_template)) {
+		throw Exception("Can't create temporary directory.", __FILE__, __LINE__);
+	}
+	const std::string directory = directory_template;
+	const std::string input_path = directory + "/input.ppm";
+	const std::string output_path = directory + "/output.ppm";
+	const std::string executable = getExecutablePath();
+
+	Image cli_image;
+	bool cli_ok = true;
+	Timer cli_timer;
+	for (unsigned int cycle = 0; cli_ok && cycle < cycles; ++cycle) {
+		Image frame_image;
+		frame_image.clearAndInitialize(width, height, false, Image::PRECISION_U16);
+		unpackImage(input_pixels, frame_image);
+		{
+			std::ofstream frame_file(input_path.c_str());
+			PpmImageWriter().save(frame_image, frame_file);
+		}
+
+		cli_ok = runApply(executable, input_path, args[1], output_path, kernel, threads);
+		if (cli_ok) {
+			std::ifstream output_file(output_path.c_str());
+			PpmImageReader(Image::PRECISION_U16).load(output_file, cli_image);
+		}
+	}
+	cli_timer.stop();
+
+	unlink(input_path.c_str());
+	unlink(output_path.c_str());
+	rmdir(directory.c_str());
+
+	if (!cli_ok) {
+		throw Exception("clutbench --apply failed.", __FILE__, __LINE__);
+	}
+
+	Image library_image;
+	library_image.clearAndInitialize(width, height, false, Image::PRECISION_U16);
+	unpackImage(output_pixels, library_image);
+	const Image::Difference difference = library_image.compare(cli_image);
+
+	const double library_msecs = static_cast<double>(library_timer.getNSecs()) / 1.0e6 / cycles;
+	const double cli_msecs = static_cast<double>(cli_timer.getNSecs()) / 1.0e6 / cycles;
+
+	std::cout << "Kernel:     " << kernel << " (" << threads << " threads, RGB16)" << std::endl;
+	std::cout << "Create:     " << static_cast<double>(create_timer.getNSecs()) / 1.0e6 << "ms (clut_create_from_memory)" << std::endl;
+	std::cout << "In-process: " << library_msecs << "ms per call (clut_apply)" << std::endl;
+	std::cout << "CLI:        " << cli_msecs << "ms per call (write, clutbench --apply, read)" << std::endl;
+	std::cout << "Speedup:    " << cli_msecs / std::max(1.0e-6, library_msecs) << std::endl;
+	std::cout
+		<< "Difference: "
+		<< difference.absolute
+		<< " (Rmax "
+		<< difference.max_r
+		<< ", Gmax "
+		<< difference.max_g
+		<< ", Bmax "
+		<< difference.max_b
+		<< ')'
+		<< std::endl;
+}
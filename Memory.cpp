@@ -0,0 +1,139 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <stdint.h>
+
+#include <sys/mman.h>
+
+#include <xmmintrin.h>
+
+#include "Memory.hpp"
+
+#include "Exception.hpp"
+
+namespace
+{
+
+	const size_t huge_page_size = 2 << 20;
+	const size_t header_size = 64;
+
+	struct Header {
+		void* mapping;
+		size_t mapping_size;
+	};
+
+	bool huge_pages = false;
+
+	size_t roundUp(size_t size, size_t multiple)
+	{
+		return (size + multiple - 1) / multiple * multiple;
+	}
+
+	void* mapHugePages(size_t size, size_t& mapping_size)
+	{
+		mapping_size = roundUp(size, huge_page_size);
+
+		void* mapping = mmap(0, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (mapping != MAP_FAILED) {
+			return mapping;
+		}
+
+		// No reserved huge pages, so map with slack, trim to 2 MiB alignment and ask for transparent ones
+		char* const unaligned = reinterpret_cast<char*>(mmap(0, mapping_size + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+		if (unaligned == MAP_FAILED) {
+			return 0;
+		}
+
+		char* const aligned = reinterpret_cast<char*>(roundUp(reinterpret_cast<uintptr_t>(unaligned), huge_page_size));
+		if (aligned != unaligned) {
+			munmap(unaligned, aligned - unaligned);
+		}
+		munmap(aligned + mapping_size, unaligned + huge_page_size - aligned);
+
+		madvise(aligned, mapping_size, MADV_HUGEPAGE);
+		return aligned;
+	}
+
+}
+
+void* allocateMemory(size_t size, size_t alignment)
+{
+	if (alignment > header_size) {
+		throw Exception("Alignment exceeds 64 bytes.", __FILE__, __LINE__);
+	}
+
+	char* base = 0;
+	Header header = {
+		0,
+		0
+	};
+
+	if (usesHugePages(size)) {
+		base = reinterpret_cast<char*>(mapHugePages(size + header_size, header.mapping_size));
+		header.mapping = base;
+	}
+	if (!base) {
+		base = reinterpret_cast<char*>(_mm_malloc(size + header_size, header_size));
+		if (!base) {
+			throw Exception("Out of memory.", __FILE__, __LINE__);
+		}
+		header.mapping = base;
+		header.mapping_size = 0;
+	}
+
+	*reinterpret_cast<Header*>(base) = header;
+	return base + header_size;
+}
+
+void freeMemory(void* pointer)
+{
+	if (!pointer) {
+		return;
+	}
+
+	const Header header = *reinterpret_cast<const Header*>(reinterpret_cast<char*>(pointer) - header_size);
+	if (header.mapping_size) {
+		munmap(header.mapping, header.mapping_size);
+	} else {
+		_mm_free(header.mapping);
+	}
+}
+
+void setHugePages(bool enabled)
+{
+	huge_pages = enabled;
+}
+
+bool getHugePages()
+{
+	return huge_pages;
+}
+
+bool usesHugePages(size_t size)
+{
+	return huge_pages && size >= huge_page_size;
+}
+
+bool isHugePageBacked(const void* pointer)
+{
+	return pointer && reinterpret_cast<const Header*>(reinterpret_cast<const char*>(pointer) - header_size)->mapping_size;
+}
@@ -0,0 +1,36 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#pragma once
+
+#include <cstddef>
+
+// Aligned allocation (at most 64 bytes) for image planes and CLUT storage
+void* allocateMemory(size_t size, size_t alignment);
+void freeMemory(void* pointer);
+
+// Backs allocations of at least one huge page with 2 MiB pages, via MAP_HUGETLB or else madvise(MADV_HUGEPAGE)
+void setHugePages(bool enabled);
+bool getHugePages();
+// Whether allocateMemory() asks for huge pages for a block of this size
+bool usesHugePages(size_t size);
+bool isHugePageBacked(const void* pointer);
@@ -0,0 +1,328 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "MicroBenchmark.hpp"
+
+#include "Arguments.hpp"
+#include "ClutMethod.hpp"
+#include "ClutMethods.hpp"
+#include "Exception.hpp"
+#include "HaldClut.hpp"
+#include "Image.hpp"
+#include "ImageFormats.hpp"
+#include "Memory.hpp"
+
+namespace
+{
+
+	struct Benchmark {
+		const char* name;
+		MicroFunction function;
+	};
+
+	// Function local, so registrars in any translation unit find it constructed
+	std::vector<Benchmark>& getBenchmarks()
+	{
+		static std::vector<Benchmark> benchmarks;
+		return benchmarks;
+	}
+
+	struct Statistics {
+		double median;
+		double mean;
+		double deviation;
+		double min;
+	};
+
+	Statistics getStatistics(std::vector<double> samples)
+	{
+		std::sort(samples.begin(), samples.end());
+
+		Statistics statistics;
+		statistics.median = samples.size() % 2 ? samples[samples.size() / 2] : (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2.0;
+		statistics.min = samples.front();
+
+		double sum = 0.0;
+		for (std::vector<double>::const_iterator samples_it = samples.begin(); samples_it != samples.end(); ++samples_it) {
+			sum += *samples_it;
+		}
+		statistics.mean = sum / samples.size();
+
+		double square_sum = 0.0;
+		for (std::vector<double>::const_iterator samples_it = samples.begin(); samples_it != samples.end(); ++samples_it) {
+			square_sum += (*samples_it - statistics.mean) * (*samples_it - statistics.mean);
+		}
+		statistics.deviation = samples.size() > 1 ? std::sqrt(square_sum / (samples.size() - 1)) : 0.0;
+
+		return statistics;
+	}
+
+	std::string formatNSecs(double nsecs)
+	{
+		std::ostringstream res;
+		res << std::fixed << std::setprecision(2);
+		if (nsecs >= 1000000.0) {
+			res << nsecs / 1000000.0 << " ms";
+		} else if (nsecs >= 1000.0) {
+			res << nsecs / 1000.0 << " us";
+		} else {
+			res << nsecs << " ns";
+		}
+		return res.str();
+	}
+
+	// Each sample repeats the benchmark until it takes at least this long
+	const unsigned long long min_sample_nsecs = 2000000;
+
+}
+
+MicroState::MicroState(ClutMethod& _clut_method, const Image& _clut_image, unsigned int _level, size_t _pixel_count) :
+	clut_method(_clut_method),
+	clut_image(_clut_image),
+	level(_level),
+	pixel_count(_pixel_count),
+	pixels(reinterpret_cast<float*>(allocateMemory(_pixel_count * 4 * sizeof(float), 16))),
+	scratch_pixels(reinterpret_cast<float*>(allocateMemory(_pixel_count * 4 * sizeof(float), 16))),
+	scratch_cells(reinterpret_cast<ClutCell*>(allocateMemory(_pixel_count * sizeof(ClutCell), 16))),
+	paused_nsecs(0),
+	items(_pixel_count),
+	skipped(false)
+{
+	unsigned int seed = 1;
+	for (size_t pixel = 0; pixel < pixel_count; ++pixel) {
+		for (unsigned int channel = 0; channel < 3; ++channel) {
+			seed = seed * 1103515245 + 12345;
+			pixels[pixel * 4 + channel] = (seed >> 8) & 0xFFFF;
+		}
+		pixels[pixel * 4 + 3] = 0.0f;
+	}
+}
+
+MicroState::~MicroState()
+{
+	freeMemory(scratch_cells);
+	freeMemory(scratch_pixels);
+	freeMemory(pixels);
+}
+
+ClutMethod& MicroState::getClutMethod() const
+{
+	return clut_method;
+}
+
+const Image& MicroState::getClutImage() const
+{
+	return clut_image;
+}
+
+unsigned int MicroState::getLevel() const
+{
+	return level;
+}
+
+const float* MicroState::getPixels() const
+{
+	return pixels;
+}
+
+size_t MicroState::getPixelCount() const
+{
+	return pixel_count;
+}
+
+float* MicroState::getScratchPixels() const
+{
+	return scratch_pixels;
+}
+
+ClutCell* MicroState::getScratchCells() const
+{
+	return scratch_cells;
+}
+
+void MicroState::pauseTiming()
+{
+	pause_timer.start();
+}
+
+void MicroState::resumeTiming()
+{
+	pause_timer.stop();
+	paused_nsecs += pause_timer.getNSecs();
+}
+
+void MicroState::setItems(size_t _items)
+{
+	items = _items;
+}
+
+void MicroState::skip()
+{
+	skipped = true;
+}
+
+MicroRegistrar::MicroRegistrar(const char* name, MicroFunction function)
+{
+	const Benchmark benchmark = {name, function};
+	getBenchmarks().push_back(benchmark);
+}
+
+int runMicroBenchmarks(const std::vector<std::string>& args)
+{
+	if (args.size() > 1 && (args[1] == "-h" || args[1] == "--help")) {
+		std::cerr << "Usage:" << args[0] << " [CLUT|LEVEL] [SAMPLES] [FILTER]" << std::endl;
+		std::cerr << "Benchmarks:";
+		for (std::vector<Benchmark>::const_iterator benchmarks_it = getBenchmarks().begin(); benchmarks_it != getBenchmarks().end(); ++benchmarks_it) {
+			std::cerr << ' ' << benchmarks_it->name;
+		}
+		std::cerr << std::endl;
+		return 1;
+	}
+
+	try {
+		Image clut_image;
+		if (args.size() > 1 && isNumber(args[1])) {
+			createIdentityHaldClut(getNumber(args[1]), clut_image);
+		} else if (args.size() > 1) {
+			loadImage(args[1], clut_image);
+		} else {
+			createIdentityHaldClut(8, clut_image);
+		}
+
+		const unsigned int level = getHaldClutLevel(clut_image);
+		if (level < 2) {
+			throw Exception("CLUT image has wrong dimensions.", __FILE__, __LINE__);
+		}
+
+		unsigned int samples = 15;
+		if (args.size() > 2) {
+			samples = std::max(getNumber(args[2]), 1u);
+		}
+
+		// Matched against "BENCHMARK/KERNEL"
+		const std::string filter = args.size() > 3 ? args[3] : std::string();
+
+		std::cout << "Level:      " << level << std::endl;
+		std::cout << "Samples:    " << samples << " of at least " << min_sample_nsecs / 1000000 << "ms" << std::endl;
+		std::cout << std::endl;
+		std::cout
+			<< std::left
+			<< std::setw(28)
+			<< "Benchmark"
+			<< std::right
+			<< std::setw(13)
+			<< "median"
+			<< std::setw(13)
+			<< "mean"
+			<< std::setw(9)
+			<< "stddev"
+			<< std::setw(13)
+			<< "min"
+			<< std::setw(11)
+			<< "calls"
+			<< std::endl;
+
+		const std::vector<ClutMethod*> clut_methods = createAllClutMethods();
+
+		try {
+			for (std::vector<Benchmark>::const_iterator benchmarks_it = getBenchmarks().begin(); benchmarks_it != getBenchmarks().end(); ++benchmarks_it) {
+				for (std::vector<ClutMethod*>::const_iterator clut_methods_it = clut_methods.begin(); clut_methods_it != clut_methods.end(); ++clut_methods_it) {
+					const std::string name = std::string(benchmarks_it->name) + '/' + (*clut_methods_it)->getFilename();
+					if (name.find(filter) == std::string::npos) {
+						continue;
+					}
+
+					(*clut_methods_it)->setClut(clut_image, level);
+					MicroState state(**clut_methods_it, clut_image, level, 4096);
+
+					// Warms up and finds the calls per sample
+					unsigned long long calls = 1;
+					for (;;) {
+						state.paused_nsecs = 0;
+						Timer timer;
+						for (unsigned long long call = 0; call < calls && !state.skipped; ++call) {
+							benchmarks_it->function(state);
+						}
+						timer.stop();
+						if (state.skipped || timer.getNSecs() - state.paused_nsecs >= min_sample_nsecs) {
+							break;
+						}
+						calls *= 2;
+					}
+
+					std::cout << std::left << std::setw(28) << name << std::right;
+					if (state.skipped) {
+						std::cout << std::setw(13) << "-" << std::endl;
+						continue;
+					}
+
+					std::vector<double> nsecs_per_item;
+					for (unsigned int sample = 0; sample < samples; ++sample) {
+						state.paused_nsecs = 0;
+						Timer timer;
+						for (unsigned long long call = 0; call < calls; ++call) {
+							benchmarks_it->function(state);
+						}
+						timer.stop();
+						nsecs_per_item.push_back(static_cast<double>(timer.getNSecs() - state.paused_nsecs) / (calls * state.items));
+					}
+
+					const Statistics statistics = getStatistics(nsecs_per_item);
+					std::cout
+						<< std::setw(13)
+						<< formatNSecs(statistics.median)
+						<< std::setw(13)
+						<< formatNSecs(statistics.mean)
+						<< std::setw(8)
+						<< std::fixed
+						<< std::setprecision(1)
+						<< 100.0 * statistics.deviation / statistics.mean
+						<< '%'
+						<< std::setw(13)
+						<< formatNSecs(statistics.min)
+						<< std::setw(11)
+						<< calls
+						<< std::endl;
+				}
+			}
+		}
+		catch (...) {
+			destroyClutMethods(clut_methods);
+			throw;
+		}
+
+		destroyClutMethods(clut_methods);
+	}
+	catch (const Exception& exception)
+	{
+		std::cerr << exception.getFile() << ':' << exception.getLine() << ": " << exception.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Timer.hpp"
+
+class ClutMethod;
+class Image;
+struct ClutCell;
+
+// What a micro benchmark works on: one kernel with its CLUT already set up
+// and a batch of random pixels
+class MicroState
+{
+public:
+	MicroState(ClutMethod& _clut_method, const Image& _clut_image, unsigned int _level, size_t _pixel_count);
+	~MicroState();
+
+	ClutMethod& getClutMethod() const;
+	const Image& getClutImage() const;
+	unsigned int getLevel() const;
+
+	// Aligned four float pixels of random colors, never modified
+	const float* getPixels() const;
+	size_t getPixelCount() const;
+	// Scratch space for as many pixels and cells
+	float* getScratchPixels() const;
+	ClutCell* getScratchCells() const;
+
+	// Excludes preparation inside the benchmark from the measurement
+	void pauseTiming();
+	void resumeTiming();
+
+	// Items done per call for the per-item figures, the pixel count by default
+	void setItems(size_t _items);
+	// Marks the kernel as not supporting the benchmark
+	void skip();
+
+private:
+	friend int runMicroBenchmarks(const std::vector<std::string>& args);
+
+	ClutMethod& clut_method;
+	const Image& clut_image;
+	const unsigned int level;
+	const size_t pixel_count;
+	float* const pixels;
+	float* const scratch_pixels;
+	ClutCell* const scratch_cells;
+
+	Timer pause_timer;
+	unsigned long long paused_nsecs;
+	size_t items;
+	bool skipped;
+};
+
+typedef void (*MicroFunction)(MicroState& state);
+
+// Adds a benchmark at static initialization, see MICRO_BENCHMARK
+class MicroRegistrar
+{
+public:
+	MicroRegistrar(const char* name, MicroFunction function);
+};
+
+// Defines and registers a benchmark function taking MicroState& state,
+// which is run for every kernel of createAllClutMethods(). Registrars must
+// be linked as objects, the linker drops them from static libraries.
+#define MICRO_BENCHMARK(NAME) \
+	static void micro_##NAME(MicroState& state); \
+	static const MicroRegistrar micro_registrar_##NAME(#NAME, micro_##NAME); \
+	static void micro_##NAME(MicroState& state)
+
+// Runs the registered benchmarks, args are [CLUT|LEVEL] [SAMPLES] [FILTER]
+int runMicroBenchmarks(const std::vector<std::string>& args);
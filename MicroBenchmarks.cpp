@@ -0,0 +1,96 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+
+#include "MicroBenchmark.hpp"
+
+#include "ClutMethod.hpp"
+
+MICRO_BENCHMARK(setClut)
+{
+	state.getClutMethod().setClut(state.getClutImage(), state.getLevel());
+	state.setItems(1);
+}
+
+MICRO_BENCHMARK(convert)
+{
+	const ClutMethod& clut_method = state.getClutMethod();
+	float* const rgb = state.getScratchPixels();
+
+	state.pauseTiming();
+	std::copy(state.getPixels(), state.getPixels() + state.getPixelCount() * 4, rgb);
+	state.resumeTiming();
+
+	for (size_t pixel = 0; pixel < state.getPixelCount(); ++pixel) {
+		clut_method.convert(rgb + pixel * 4);
+	}
+}
+
+MICRO_BENCHMARK(convertRow)
+{
+	float* const rgb = state.getScratchPixels();
+
+	state.pauseTiming();
+	std::copy(state.getPixels(), state.getPixels() + state.getPixelCount() * 4, rgb);
+	state.resumeTiming();
+
+	state.getClutMethod().convertRow(rgb, state.getPixelCount());
+}
+
+// Index computation alone: scaling, clamping and flattening to the cell
+MICRO_BENCHMARK(locateCell)
+{
+	const ClutMethod& clut_method = state.getClutMethod();
+	const float* const rgb = state.getPixels();
+	ClutCell* const cells = state.getScratchCells();
+
+	for (size_t pixel = 0; pixel < state.getPixelCount(); ++pixel) {
+		if (!clut_method.locateCell(rgb + pixel * 4, cells[pixel])) {
+			state.skip();
+			return;
+		}
+	}
+}
+
+// Interpolation alone: fetching the cell's corners and blending them
+MICRO_BENCHMARK(interpolateCell)
+{
+	const ClutMethod& clut_method = state.getClutMethod();
+	float* const rgb = state.getScratchPixels();
+	ClutCell* const cells = state.getScratchCells();
+
+	state.pauseTiming();
+	std::copy(state.getPixels(), state.getPixels() + state.getPixelCount() * 4, rgb);
+	for (size_t pixel = 0; pixel < state.getPixelCount(); ++pixel) {
+		if (!clut_method.locateCell(rgb + pixel * 4, cells[pixel])) {
+			state.skip();
+			state.resumeTiming();
+			return;
+		}
+	}
+	state.resumeTiming();
+
+	for (size_t pixel = 0; pixel < state.getPixelCount(); ++pixel) {
+		clut_method.interpolateCell(cells[pixel], rgb + pixel * 4);
+	}
+}
@@ -0,0 +1,163 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+
+#include "MultiBenchMode.hpp"
+
+#include "Arguments.hpp"
+#include "Exception.hpp"
+#include "HaldClut.hpp"
+#include "Image.hpp"
+#include "Memory.hpp"
+#include "MultiClutMethod.hpp"
+#include "PpmImageReader.hpp"
+#include "SseClutMethod.hpp"
+#include "TestBench.hpp"
+#include "Timer.hpp"
+
+namespace
+{
+
+	void destroyImages(const std::vector<Image*>& images)
+	{
+		for (std::vector<Image*>::const_iterator images_it = images.begin(); images_it != images.end(); ++images_it) {
+			delete *images_it;
+		}
+	}
+
+}
+
+const char* MultiBenchMode::getName() const
+{
+	return "--multi";
+}
+
+const char* MultiBenchMode::getUsage() const
+{
+	return "INPUT CLUT [CLUT...] [CYCLES]";
+}
+
+unsigned int MultiBenchMode::getMinimumArgumentCount() const
+{
+	return 2;
+}
+
+void MultiBenchMode::run(const std::vector<std::string>& args)
+{
+	std::ifstream input_file(args[0].c_str());
+	Image input_image;
+	PpmImageReader().load(input_file, input_image);
+
+	// A trailing number is no CLUT
+	std::vector<std::string>::const_iterator clut_args_end = args.end();
+	unsigned int cycles = 3;
+	if (args.size() > 2 && isNumber(args.back())) {
+		--clut_args_end;
+		cycles = std::max(1u, getNumber(args.back()));
+	}
+
+	std::vector<Image*> clut_images;
+	std::vector<Image*> separate_output_images;
+	std::vector<Image*> multi_output_images;
+	float* rgb_outputs = 0;
+
+	try {
+		for (std::vector<std::string>::const_iterator args_it = args.begin() + 1; args_it != clut_args_end; ++args_it) {
+			std::ifstream clut_file(args_it->c_str());
+			clut_images.push_back(new Image);
+			PpmImageReader().load(clut_file, *clut_images.back());
+		}
+
+		const unsigned int level = getHaldClutLevel(*clut_images.front());
+		if (level < 2) {
+			throw Exception("CLUT image has wrong dimensions.", __FILE__, __LINE__);
+		}
+
+		// Separate: One pass per CLUT
+		SseClutMethod sse_clut_method;
+		unsigned long long separate_nsecs = 0;
+		for (std::vector<Image*>::const_iterator clut_images_it = clut_images.begin(); clut_images_it != clut_images.end(); ++clut_images_it) {
+			TestBench test_bench(input_image, **clut_images_it);
+			separate_nsecs += test_bench.run(&sse_clut_method, cycles).getNSecs();
+			separate_output_images.push_back(new Image(test_bench.getOutputImage()));
+		}
+
+		// Multi: One pass for all CLUTs
+		MultiClutMethod multi_clut_method;
+		multi_clut_method.setCluts(std::vector<const Image*>(clut_images.begin(), clut_images.end()), level);
+
+		const unsigned int clut_count = multi_clut_method.getClutCount();
+		for (unsigned int clut = 0; clut < clut_count; ++clut) {
+			multi_output_images.push_back(new Image);
+			multi_output_images.back()->clearAndInitialize(input_image.getWidth(), input_image.getHeight(), false);
+		}
+		rgb_outputs = reinterpret_cast<float*>(allocateMemory(clut_count * 4 * sizeof(float), 4 * sizeof(float)));
+
+		Timer multi_timer;
+		for (unsigned int cycle = 0; cycle < cycles; ++cycle) {
+			for (unsigned int y = 0; y < input_image.getHeight(); ++y) {
+				for (unsigned int x = 0; x < input_image.getWidth(); ++x) {
+					float rgb[4] __attribute__((aligned(16)));
+					rgb[0] = input_image.getR(x, y);
+					rgb[1] = input_image.getG(x, y);
+					rgb[2] = input_image.getB(x, y);
+					rgb[3] = 0.0f;
+					multi_clut_method.convert(rgb, rgb_outputs);
+					for (unsigned int clut = 0; clut < clut_count; ++clut) {
+						multi_output_images[clut]->setR(x, y, rgb_outputs[clut * 4]);
+						multi_output_images[clut]->setG(x, y, rgb_outputs[clut * 4 + 1]);
+						multi_output_images[clut]->setB(x, y, rgb_outputs[clut * 4 + 2]);
+					}
+				}
+			}
+		}
+		multi_timer.stop();
+
+		unsigned int max_difference = 0;
+		for (unsigned int clut = 0; clut < clut_count; ++clut) {
+			const Image::Difference difference = separate_output_images[clut]->compare(*multi_output_images[clut]);
+			max_difference = std::max(max_difference, std::max(difference.max_r, std::max(difference.max_g, difference.max_b)));
+		}
+
+		std::cout << "Method:     " << multi_clut_method.getDescription() << std::endl;
+		std::cout << "CLUTs:      " << clut_count << " of level " << level << std::endl;
+		std::cout << "Separate:   " << separate_nsecs / cycles / 1000000 << "ms" << std::endl;
+		std::cout << "Multi:      " << multi_timer.getNSecs() / cycles / 1000000 << "ms" << std::endl;
+		std::cout << "Speedup:    " << static_cast<float>(separate_nsecs) / static_cast<float>(std::max(1ull, multi_timer.getNSecs())) << std::endl;
+		std::cout << "Difference: max " << max_difference << std::endl;
+	}
+	catch (...) {
+		freeMemory(rgb_outputs);
+		destroyImages(multi_output_images);
+		destroyImages(separate_output_images);
+		destroyImages(clut_images);
+		throw;
+	}
+
+	freeMemory(rgb_outputs);
+	destroyImages(multi_output_images);
+	destroyImages(separate_output_images);
+	destroyImages(clut_images);
+}
@@ -0,0 +1,159 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+
+#include <xmmintrin.h>
+
+#include "MultiClutMethod.hpp"
+
+#include "Exception.hpp"
+#include "Image.hpp"
+#include "Memory.hpp"
+
+namespace
+{
+
+	inline __m128 getClutValue(const unsigned short* clut_image, size_t index)
+	{
+		return _mm_cvtpu16_ps(*reinterpret_cast<const __m64*>(clut_image + index));
+	}
+
+}
+
+MultiClutMethod::MultiClutMethod() :
+	clut_image(0),
+	clut_count(0),
+	clut_level(0)
+{
+}
+
+MultiClutMethod::~MultiClutMethod()
+{
+	freeMemory(clut_image);
+}
+
+const char* MultiClutMethod::getDescription() const
+{
+	return "Interleaved integer storage of N CLUTs with shared SSE weights";
+}
+
+void MultiClutMethod::setCluts(const std::vector<const Image*>& images, unsigned int level)
+{
+	const unsigned int size = level * level * level;
+	for (std::vector<const Image*>::const_iterator images_it = images.begin(); images_it != images.end(); ++images_it) {
+		if ((*images_it)->getWidth() != size || (*images_it)->getHeight() != size) {
+			throw Exception("CLUTs must share the same level.", __FILE__, __LINE__);
+		}
+	}
+
+	freeMemory(clut_image);
+
+	clut_count = images.size();
+
+	const size_t entry_size = static_cast<size_t>(clut_count) * 4;
+
+	clut_image = reinterpret_cast<unsigned short*>(allocateMemory(static_cast<size_t>(size) * size * entry_size * sizeof(unsigned short), 4 * sizeof(unsigned short)));
+
+	for (unsigned int clut = 0; clut < clut_count; ++clut) {
+		const Image& image = *images[clut];
+
+		size_t index = clut * 4;
+		for (unsigned int y = 0; y < size; ++y) {
+			for (unsigned int x = 0; x < size; ++x) {
+				clut_image[index] = image.getR(x, y);
+				clut_image[index + 1] = image.getG(x, y);
+				clut_image[index + 2] = image.getB(x, y);
+				clut_image[index + 3] = 0;
+				index += entry_size;
+			}
+		}
+	}
+
+	clut_level = level * level;
+	flevel_minus_one = static_cast<float>(clut_level - 1) / 65535.0f;
+	flevel_minus_two = static_cast<float>(clut_level - 2);
+}
+
+unsigned int MultiClutMethod::getClutCount() const
+{
+	return clut_count;
+}
+
+void MultiClutMethod::convert(const float* rgb, float* rgb_outputs) const
+{
+	const unsigned int level = clut_level; // This is important
+
+	const unsigned int red = std::min(flevel_minus_two, rgb[0] * flevel_minus_one);
+	const unsigned int green = std::min(flevel_minus_two, rgb[1] * flevel_minus_one);
+	const unsigned int blue = std::min(flevel_minus_two, rgb[2] * flevel_minus_one);
+
+	const __m128 v_rgb = _mm_load_ps(rgb) *_mm_load_ps1(&flevel_minus_one) - _mm_set_ps(0.0f, blue, green, red);
+
+	const unsigned int level_square = level * level;
+
+	const unsigned int color = red + green * level + blue * level_square;
+
+	// Computed once, used for every CLUT
+	const size_t entry_size = static_cast<size_t>(clut_count) * 4;
+	const size_t index[8] = {
+		color * entry_size,
+		(color + 1) * entry_size,
+		(color + level) * entry_size,
+		(color + level + 1) * entry_size,
+		(color + level_square) * entry_size,
+		(color + level_square + 1) * entry_size,
+		(color + level + level_square) * entry_size,
+		(color + level + level_square + 1) * entry_size
+	};
+
+	const __m128 v_r = _mm_shuffle_ps(v_rgb, v_rgb, 0x00);
+	const __m128 v_one_minus_r = _mm_set_ps1(1.0f) - v_r;
+	const __m128 v_g = _mm_shuffle_ps(v_rgb, v_rgb, 0x55);
+	const __m128 v_one_minus_g = _mm_set_ps1(1.0f) - v_g;
+	const __m128 v_b = _mm_shuffle_ps(v_rgb, v_rgb, 0xAA);
+	const __m128 v_one_minus_b = _mm_set_ps1(1.0f) - v_b;
+
+	for (unsigned int clut = 0; clut < clut_count; ++clut) {
+		const unsigned short* const clut_entry = clut_image + clut * 4;
+
+		__m128 v_tmp1 = getClutValue(clut_entry, index[0]) * v_one_minus_r + getClutValue(clut_entry, index[1]) * v_r;
+		__m128 v_tmp2 = getClutValue(clut_entry, index[2]) * v_one_minus_r + getClutValue(clut_entry, index[3]) * v_r;
+
+		const __m128 v_out = v_tmp1 * v_one_minus_g + v_tmp2 * v_g;
+
+		v_tmp1 = getClutValue(clut_entry, index[4]) * v_one_minus_r + getClutValue(clut_entry, index[5]) * v_r;
+		v_tmp2 = getClutValue(clut_entry, index[6]) * v_one_minus_r + getClutValue(clut_entry, index[7]) * v_r;
+
+		v_tmp1 = v_tmp1 * v_one_minus_g + v_tmp2 * v_g;
+
+		_mm_store_ps(rgb_outputs + clut * 4, v_out * v_one_minus_b + v_tmp1 * v_b);
+	}
+}
+
+size_t MultiClutMethod::getClutFootprint() const
+{
+	if (!clut_image) {
+		return 0;
+	}
+	return static_cast<size_t>(clut_level) * clut_level * clut_level * clut_count * 4 * sizeof(unsigned short);
+}
@@ -0,0 +1,59 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+class Image;
+
+// Applies N CLUTs of the same level in one pass: The lattice position and
+// weights are computed once per pixel and reused for every CLUT. The CLUTs
+// are stored interleaved per lattice entry, so the N values of a corner are
+// adjacent in memory.
+class MultiClutMethod
+{
+public:
+	MultiClutMethod();
+	~MultiClutMethod();
+
+	const char* getDescription() const;
+
+	void setCluts(const std::vector<const Image*>& images, unsigned int level);
+	unsigned int getClutCount() const;
+
+	// Writes four floats per CLUT into rgb_outputs (16 byte aligned)
+	void convert(const float* rgb, float* rgb_outputs) const;
+
+	size_t getClutFootprint() const;
+
+private:
+	MultiClutMethod(const MultiClutMethod& other);
+	MultiClutMethod& operator =(const MultiClutMethod& other);
+
+	unsigned short* clut_image;
+	unsigned int clut_count;
+	unsigned int clut_level;
+	float flevel_minus_one;
+	float flevel_minus_two;
+};
@@ -0,0 +1,122 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+
+#include "NearestClutMethod.hpp"
+
+#include "Memory.hpp"
+
+NearestClutMethod::NearestClutMethod() :
+	clut_storage(0),
+	clut_image(0),
+	clut_level(0),
+	strength(1.0f)
+{
+}
+
+NearestClutMethod::~NearestClutMethod()
+{
+	freeMemory(clut_storage);
+}
+
+const char* NearestClutMethod::getDescription() const
+{
+	return "Nearest lattice point without interpolation (previews only)";
+}
+
+const char* NearestClutMethod::getFilename() const
+{
+	return "nearest";
+}
+
+void NearestClutMethod::setClut(const Image& image, unsigned int level)
+{
+	freeMemory(clut_storage);
+	const size_t size = static_cast<size_t>(image.getWidth()) * image.getHeight();
+	clut_storage = reinterpret_cast<unsigned short*>(allocateMemory(size * 4 * sizeof(unsigned short), 4 * sizeof(unsigned short)));
+	size_t index = 0;
+	for (unsigned int y = 0; y < image.getHeight(); ++y) {
+		for (unsigned int x = 0; x < image.getWidth(); ++x) {
+			clut_storage[index] = image.getR(x, y);
+			++index;
+			clut_storage[index] = image.getG(x, y);
+			++index;
+			clut_storage[index] = image.getB(x, y);
+			index += 2;
+		}
+	}
+
+	clut_image = clut_storage;
+
+	clut_level = level * level;
+	flevel_minus_one = static_cast<float>(clut_level - 1) / 65535.0f;
+}
+
+bool NearestClutMethod::setPackedClut(const unsigned short* packed_clut, unsigned int level)
+{
+	freeMemory(clut_storage);
+	clut_storage = 0;
+
+	clut_image = packed_clut;
+
+	clut_level = level * level;
+	flevel_minus_one = static_cast<float>(clut_level - 1) / 65535.0f;
+
+	return true;
+}
+
+void NearestClutMethod::convert(float* rgb) const
+{
+	const unsigned int level = clut_level;
+	const float flevel_max = static_cast<float>(level - 1);
+
+	// Rounding instead of truncating picks the closest of the eight corners
+	const unsigned int red = std::max(0.0f, std::min(flevel_max, rgb[0] * flevel_minus_one + 0.5f));
+	const unsigned int green = std::max(0.0f, std::min(flevel_max, rgb[1] * flevel_minus_one + 0.5f));
+	const unsigned int blue = std::max(0.0f, std::min(flevel_max, rgb[2] * flevel_minus_one + 0.5f));
+
+	const size_t index = (static_cast<size_t>(red) + green * level + static_cast<size_t>(blue) * level * level) * 4;
+
+	if (strength != 1.0f) {
+		rgb[0] += strength * (clut_image[index] - rgb[0]);
+		rgb[1] += strength * (clut_image[index + 1] - rgb[1]);
+		rgb[2] += strength * (clut_image[index + 2] - rgb[2]);
+	} else {
+		rgb[0] = clut_image[index];
+		rgb[1] = clut_image[index + 1];
+		rgb[2] = clut_image[index + 2];
+	}
+}
+
+void NearestClutMethod::setStrength(float _strength)
+{
+	strength = _strength;
+}
+
+size_t NearestClutMethod::getClutFootprint() const
+{
+	if (!clut_image) {
+		return 0;
+	}
+	return static_cast<size_t>(clut_level) * clut_level * clut_level * 4 * sizeof(unsigned short);
+}
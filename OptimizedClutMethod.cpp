@@ -37,6 +37,12 @@ namespace
 
 }
 
+OptimizedClutMethod::OptimizedClutMethod() :
+	clut_level(0),
+	strength(1.0f)
+{
+}
+
 const char* OptimizedClutMethod::getDescription() const
 {
 	return "Optimized and cleaned up code";
@@ -108,7 +114,27 @@ void OptimizedClutMethod::convert(float* rgb) const
 	tmp1[1] = tmp1[1] * (1 - g) + tmp2[1] * g;
 	tmp1[2] = tmp1[2] * (1 - g) + tmp2[2] * g;
 
-	rgb[0] = out[0] * (1 - b) + tmp1[0] * b;
-	rgb[1] = out[1] * (1 - b) + tmp1[1] * b;
-	rgb[2] = out[2] * (1 - b) + tmp1[2] * b;
+	out[0] = out[0] * (1 - b) + tmp1[0] * b;
+	out[1] = out[1] * (1 - b) + tmp1[1] * b;
+	out[2] = out[2] * (1 - b) + tmp1[2] * b;
+
+	if (strength != 1.0f) {
+		rgb[0] += strength * (out[0] - rgb[0]);
+		rgb[1] += strength * (out[1] - rgb[1]);
+		rgb[2] += strength * (out[2] - rgb[2]);
+	} else {
+		rgb[0] = out[0];
+		rgb[1] = out[1];
+		rgb[2] = out[2];
+	}
+}
+
+void OptimizedClutMethod::setStrength(float _strength)
+{
+	strength = _strength;
+}
+
+size_t OptimizedClutMethod::getClutFootprint() const
+{
+	return static_cast<size_t>(clut_image.getWidth()) * clut_image.getHeight() * 3 * sizeof(float);
 }
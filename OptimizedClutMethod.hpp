@@ -29,15 +29,21 @@ class OptimizedClutMethod :
 	public ClutMethod
 {
 public:
+	OptimizedClutMethod();
+
 	const char* getDescription() const;
 	const char* getFilename() const;
 
 	void setClut(const Image& image, unsigned int level);
 	void convert(float* rgb) const;
+	void setStrength(float _strength);
+
+	size_t getClutFootprint() const;
 
 private:
 	Image clut_image;
 	unsigned int clut_level;
 	float flevel_minus_one;
 	float flevel_minus_two;
+	float strength;
 };
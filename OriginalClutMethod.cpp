@@ -33,6 +33,12 @@ namespace
 
 }
 
+OriginalClutMethod::OriginalClutMethod() :
+	clut_level(0),
+	strength(1.0f)
+{
+}
+
 const char* OriginalClutMethod::getDescription() const
 {
 	return "Original RawTherapee 4.2 (adapted implementation)";
@@ -49,7 +55,7 @@ void OriginalClutMethod::setClut(const Image& image, unsigned int level)
 	clut_level = level;
 }
 
-void OriginalClutMethod::convert(float* rgb) const
+inline void OriginalClutMethod::applyClut(float* rgb) const
 {
 	rgb[0] /= 65535.0f;
 	rgb[1] /= 65535.0f;
@@ -133,3 +139,34 @@ void OriginalClutMethod::convert(float* rgb) const
 	rgb[1] = rgb[1] * (1 - b) + tmp[1] * b;
 	rgb[2] = rgb[2] * (1 - b) + tmp[2] * b;
 }
+
+void OriginalClutMethod::convert(float* rgb) const
+{
+	// The reference stays untouched at full strength
+	if (strength == 1.0f) {
+		applyClut(rgb);
+		return;
+	}
+
+	const float input[3] = {
+		rgb[0],
+		rgb[1],
+		rgb[2]
+	};
+
+	applyClut(rgb);
+
+	rgb[0] = input[0] + strength * (rgb[0] - input[0]);
+	rgb[1] = input[1] + strength * (rgb[1] - input[1]);
+	rgb[2] = input[2] + strength * (rgb[2] - input[2]);
+}
+
+void OriginalClutMethod::setStrength(float _strength)
+{
+	strength = _strength;
+}
+
+size_t OriginalClutMethod::getClutFootprint() const
+{
+	return static_cast<size_t>(clut_image.getWidth()) * clut_image.getHeight() * 3 * sizeof(float);
+}
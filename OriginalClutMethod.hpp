@@ -29,13 +29,22 @@ class OriginalClutMethod :
 	public ClutMethod
 {
 public:
+	OriginalClutMethod();
+
 	const char* getDescription() const;
 	const char* getFilename() const;
 
 	void setClut(const Image& image, unsigned int level);
 	void convert(float* rgb) const;
+	void setStrength(float _strength);
+
+	size_t getClutFootprint() const;
 
 private:
+	// The RawTherapee 4.2 code as it was, convert() only adds the strength blend
+	void applyClut(float* rgb) const __attribute__((always_inline));
+
 	Image clut_image;
 	unsigned int clut_level;
+	float strength;
 };
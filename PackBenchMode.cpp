@@ -0,0 +1,91 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <iostream>
+#include <fstream>
+
+#include "PackBenchMode.hpp"
+
+#include "ClutFile.hpp"
+#include "Exception.hpp"
+#include "HaldClut.hpp"
+#include "Image.hpp"
+#include "PpmImageReader.hpp"
+#include "SseClutMethod.hpp"
+#include "Timer.hpp"
+
+const char* PackBenchMode::getName() const
+{
+	return "--pack";
+}
+
+const char* PackBenchMode::getUsage() const
+{
+	return "CLUT OUTPUT";
+}
+
+unsigned int PackBenchMode::getMinimumArgumentCount() const
+{
+	return 2;
+}
+
+void PackBenchMode::run(const std::vector<std::string>& args)
+{
+	Timer parse_timer;
+	std::ifstream clut_stream(args[0].c_str());
+	Image clut_image;
+	PpmImageReader().load(clut_stream, clut_image);
+	parse_timer.stop();
+
+	const unsigned int level = getHaldClutLevel(clut_image);
+	if (level < 2) {
+		throw Exception("CLUT image has wrong dimensions.", __FILE__, __LINE__);
+	}
+
+	SseClutMethod clut_method;
+
+	Timer set_timer;
+	clut_method.setClut(clut_image, level);
+	set_timer.stop();
+
+	ClutFile::save(clut_image, args[1]);
+
+	ClutFile clut_file;
+
+	Timer map_timer;
+	clut_file.load(args[1]);
+	map_timer.stop();
+
+	Timer verify_timer;
+	if (!clut_file.verify()) {
+		throw Exception("CLUT file checksum mismatch.", __FILE__, __LINE__);
+	}
+	verify_timer.stop();
+
+	Timer set_packed_timer;
+	clut_method.setPackedClut(clut_file.getData(), clut_file.getLevel());
+	set_packed_timer.stop();
+
+	std::cout << "Level:      " << level << std::endl;
+	std::cout << "PPM:        " << parse_timer.getUSecs() << "us parse + " << set_timer.getUSecs() << "us setClut()" << std::endl;
+	std::cout << "Packed:     " << map_timer.getUSecs() << "us map + " << verify_timer.getUSecs() << "us verify + " << set_packed_timer.getUSecs() << "us setPackedClut()" << std::endl;
+}
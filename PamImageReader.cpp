@@ -0,0 +1,154 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <istream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "PamImageReader.hpp"
+#include "Exception.hpp"
+#include "Image.hpp"
+
+PamImageReader::PamImageReader(Image::Precision _precision) :
+	precision(_precision)
+{
+}
+
+void PamImageReader::load(std::istream& stream, Image& image)
+{
+	std::string line;
+
+	if (!std::getline(stream, line) || line != "P7") {
+		throw Exception("Image not a portable arbitrary map.", __FILE__, __LINE__);
+	}
+
+	unsigned long width = 0;
+	unsigned long height = 0;
+	unsigned long depth = 0;
+	unsigned long max_value = 0;
+	std::string tuple_type;
+	bool end_of_header = false;
+
+	while (!end_of_header && std::getline(stream, line)) {
+		std::istringstream fields(line);
+		std::string token;
+		if (!(fields >> token) || token[0] == '#') {
+			continue;
+		}
+
+		if (token == "ENDHDR") {
+			end_of_header = true;
+		} else if (token == "WIDTH") {
+			fields >> width;
+		} else if (token == "HEIGHT") {
+			fields >> height;
+		} else if (token == "DEPTH") {
+			fields >> depth;
+		} else if (token == "MAXVAL") {
+			fields >> max_value;
+		} else if (token == "TUPLTYPE") {
+			std::string type;
+			while (fields >> type) {
+				tuple_type += tuple_type.empty() ? type : ' ' + type;
+			}
+		}
+
+		if (fields.bad()) {
+			throw Exception("Malformed PAM image header.", __FILE__, __LINE__);
+		}
+	}
+
+	if (
+		!end_of_header
+		|| !width
+		|| !height
+		|| !max_value
+		|| max_value > 65535
+		|| !(
+			(depth == 3 && (tuple_type.empty() || tuple_type == "RGB"))
+			|| (depth == 4 && (tuple_type.empty() || tuple_type == "RGB_ALPHA"))
+		)
+	) {
+		throw Exception("Malformed PAM image header.", __FILE__, __LINE__);
+	}
+
+	image.clearAndInitialize(width, height, false, precision);
+	if (depth == 4) {
+		image.addAlpha();
+	}
+
+	const size_t sample_size = max_value > 255 ? 2 : 1;
+	// Exact for the usual 255 and 65535, so alpha survives a 16b round trip unchanged
+	const float factor = 65535.0f / static_cast<float>(max_value);
+	std::vector<char> row(width * depth * sample_size);
+
+	for (unsigned int y = 0; y < height; ++y) {
+		if (!stream.read(&row[0], row.size())) {
+			throw Exception("Corrupt PAM image body.", __FILE__, __LINE__);
+		}
+
+		size_t index = 0;
+		for (unsigned int x = 0; x < width; ++x) {
+			for (unsigned int p = 0; p < depth; ++p) {
+				unsigned short value = static_cast<unsigned char>(row[index]);
+				++index;
+				if (sample_size > 1) {
+					value <<= 8;
+					value |= static_cast<unsigned char>(row[index]);
+					++index;
+				}
+
+				if (precision == Image::PRECISION_U16) {
+					if (max_value != 65535) {
+						value = (static_cast<unsigned long>(value) * 65535 + max_value / 2) / max_value;
+					}
+					static_cast<unsigned short*>(image.getRow(p, y))[x] = value;
+					continue;
+				}
+
+				const float normalized_value = static_cast<float>(value) * factor;
+				switch (p) {
+					case 0: {
+						image.setR(x, y, normalized_value);
+						break;
+					}
+
+					case 1: {
+						image.setG(x, y, normalized_value);
+						break;
+					}
+
+					case 2: {
+						image.setB(x, y, normalized_value);
+						break;
+					}
+
+					case 3: {
+						image.setA(x, y, normalized_value);
+						break;
+					}
+				}
+			}
+		}
+	}
+}
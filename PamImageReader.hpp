@@ -0,0 +1,42 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#pragma once
+
+#include "ImageReader.hpp"
+#include "Image.hpp"
+
+// Portable arbitrary map with the RGB or RGB_ALPHA tuple type. The alpha
+// channel goes to the alpha plane of the image, the conversions pass it
+// through untouched.
+class PamImageReader :
+	public ImageReader
+{
+public:
+	// With PRECISION_U16 the samples are stored as read, scaled to 16b only if needed
+	PamImageReader(Image::Precision _precision = Image::PRECISION_FLOAT);
+
+	void load(std::istream& stream, Image& image);
+
+private:
+	const Image::Precision precision;
+};
@@ -0,0 +1,101 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <iostream>
+#include <vector>
+
+#include "PamImageWriter.hpp"
+#include "Exception.hpp"
+#include "Image.hpp"
+
+PamImageWriter::PamImageWriter(bool _eight_bit) :
+	eight_bit(_eight_bit)
+{
+}
+
+void PamImageWriter::save(const Image& image, std::ostream& stream)
+{
+	if (!stream) {
+		throw Exception("Bad stream.", __FILE__, __LINE__);
+	}
+
+	const unsigned int depth = image.hasAlpha() ? 4 : 3;
+
+	stream << "P7\n";
+	stream << "# Created by clutbench\n";
+	stream << "WIDTH " << image.getWidth() << '\n';
+	stream << "HEIGHT " << image.getHeight() << '\n';
+	stream << "DEPTH " << depth << '\n';
+	stream << "MAXVAL " << (eight_bit ? 255 : 65535) << '\n';
+	stream << "TUPLTYPE " << (image.hasAlpha() ? "RGB_ALPHA" : "RGB") << '\n';
+	stream << "ENDHDR\n";
+
+	std::vector<char> row(static_cast<size_t>(image.getWidth()) * depth * (eight_bit ? 1 : 2));
+
+	for (unsigned int y = 0; y < image.getHeight(); ++y) {
+		size_t index = 0;
+		for (unsigned int x = 0; x < image.getWidth(); ++x) {
+			for (unsigned int p = 0; p < depth; ++p) {
+				unsigned short value = 0;
+				if (image.getPrecision() == Image::PRECISION_U16) {
+					// No float round trip for samples kept as read
+					value = static_cast<const unsigned short*>(image.getRow(p, y))[x];
+				} else {
+					switch (p) {
+						case 0: {
+							value = image.getR(x, y);
+							break;
+						}
+
+						case 1: {
+							value = image.getG(x, y);
+							break;
+						}
+
+						case 2: {
+							value = image.getB(x, y);
+							break;
+						}
+
+						case 3: {
+							value = image.getA(x, y);
+							break;
+						}
+					}
+				}
+
+				if (eight_bit) {
+					row[index] = value >> 8;
+					++index;
+				} else {
+					row[index] = value >> 8;
+					row[index + 1] = value & 0xFF;
+					index += 2;
+				}
+			}
+		}
+
+		if (!row.empty() && !stream.write(&row[0], row.size())) {
+			throw Exception("Bad stream.", __FILE__, __LINE__);
+		}
+	}
+}
@@ -0,0 +1,221 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <istream>
+#include <sstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <xmmintrin.h>
+
+#include "PfmImageReader.hpp"
+#include "Exception.hpp"
+#include "Image.hpp"
+
+namespace
+{
+
+	// Headers are short, anything longer is not a PFM image
+	const size_t max_header_size = 256;
+
+	void readHeader(std::istream& stream, unsigned long& width, unsigned long& height, float& scale)
+	{
+		char c;
+
+		if (
+			!stream.get(c)
+			|| c != 'P'
+			|| !stream.get(c)
+			|| c != 'F'
+		) {
+			throw Exception("Image not a color portable float map.", __FILE__, __LINE__);
+		}
+
+		if (
+			!(stream >> width)
+			|| !(stream >> height)
+			|| !(stream >> scale)
+			|| !stream.get(c)
+			|| (c != '\n' && c != ' ' && c != '\t' && c != '\r')
+			|| scale == 0.0f
+		) {
+			throw Exception("Malformed PFM image header.", __FILE__, __LINE__);
+		}
+	}
+
+	bool isLittleEndianHost()
+	{
+		const unsigned short probe = 1;
+		return *reinterpret_cast<const unsigned char*>(&probe) == 1;
+	}
+
+	float readSample(const char* data, bool swap_bytes)
+	{
+		char bytes[sizeof(float)];
+		if (swap_bytes) {
+			std::reverse_copy(data, data + sizeof(float), bytes);
+		} else {
+			std::memcpy(bytes, data, sizeof(float));
+		}
+
+		float res;
+		std::memcpy(&res, bytes, sizeof(float));
+		return res;
+	}
+
+}
+
+PfmImageReader::PfmImageReader(Image::Precision _precision) :
+	precision(_precision)
+{
+}
+
+void PfmImageReader::load(std::istream& stream, Image& image)
+{
+	unsigned long width;
+	unsigned long height;
+	float scale;
+
+	readHeader(stream, width, height, scale);
+
+	image.clearAndInitialize(width, height, false, precision);
+
+	const bool swap_bytes = (scale < 0.0f) != isLittleEndianHost();
+	const float factor = std::abs(scale) * 65535.0f;
+	std::vector<char> row(width * 3 * sizeof(float));
+
+	for (unsigned int y = height; y > 0; --y) {
+		if (!row.empty() && !stream.read(&row[0], row.size())) {
+			throw Exception("Corrupt PFM image body.", __FILE__, __LINE__);
+		}
+		storeRow(row.empty() ? 0 : &row[0], swap_bytes, factor, image, y - 1);
+	}
+}
+
+void PfmImageReader::loadFile(const std::string& path, Image& image)
+{
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw Exception("Can't open PFM image.", __FILE__, __LINE__);
+	}
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) || file_stat.st_size == 0) {
+		close(fd);
+		throw Exception("Malformed PFM image header.", __FILE__, __LINE__);
+	}
+
+	const size_t mapping_size = file_stat.st_size;
+	void* const mapping = mmap(0, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		throw Exception("Can't map PFM image.", __FILE__, __LINE__);
+	}
+	// Rows are consumed once, front to back in the file
+	madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+
+	const char* const data = static_cast<const char*>(mapping);
+
+	try {
+		std::istringstream header(std::string(data, std::min(mapping_size, max_header_size)));
+
+		unsigned long width;
+		unsigned long height;
+		float scale;
+
+		readHeader(header, width, height, scale);
+
+		const size_t body_offset = header.tellg();
+		const size_t row_size = width * 3 * sizeof(float);
+		if (mapping_size < body_offset + row_size * height) {
+			throw Exception("Corrupt PFM image body.", __FILE__, __LINE__);
+		}
+
+		image.clearAndInitialize(width, height, false, precision);
+
+		const bool swap_bytes = (scale < 0.0f) != isLittleEndianHost();
+		const float factor = std::abs(scale) * 65535.0f;
+
+		for (unsigned int y = height; y > 0; --y) {
+			storeRow(data + body_offset + (height - y) * row_size, swap_bytes, factor, image, y - 1);
+		}
+	} catch (...) {
+		munmap(mapping, mapping_size);
+		throw;
+	}
+
+	munmap(mapping, mapping_size);
+}
+
+void PfmImageReader::storeRow(const char* data, bool swap_bytes, float factor, Image& image, unsigned int y) const
+{
+	const unsigned int width = image.getWidth();
+	unsigned int x = 0;
+
+	if (!swap_bytes && precision == Image::PRECISION_FLOAT) {
+		// Deinterleaves, scales and clamps four pixels per iteration
+		const float* const samples = reinterpret_cast<const float*>(data);
+		float* const red = static_cast<float*>(image.getRow(0, y));
+		float* const green = static_cast<float*>(image.getRow(1, y));
+		float* const blue = static_cast<float*>(image.getRow(2, y));
+
+		const __m128 v_factor = _mm_set_ps1(factor);
+		const __m128 v_min = _mm_setzero_ps();
+		const __m128 v_max = _mm_set_ps1(65535.0f);
+
+		for (; x + 4 <= width; x += 4) {
+			// r0 g0 b0 r1 | g1 b1 r2 g2 | b2 r3 g3 b3
+			const __m128 v_a = _mm_loadu_ps(samples + x * 3);
+			const __m128 v_b = _mm_loadu_ps(samples + x * 3 + 4);
+			const __m128 v_c = _mm_loadu_ps(samples + x * 3 + 8);
+
+			const __m128 v_r = _mm_shuffle_ps(v_a, _mm_shuffle_ps(v_b, v_c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+			const __m128 v_g = _mm_shuffle_ps(
+				_mm_shuffle_ps(v_a, v_b, _MM_SHUFFLE(0, 0, 1, 1)),
+				_mm_shuffle_ps(v_b, v_c, _MM_SHUFFLE(2, 2, 3, 3)),
+				_MM_SHUFFLE(2, 0, 2, 0)
+			);
+			const __m128 v_bl = _mm_shuffle_ps(
+				_mm_shuffle_ps(v_a, v_b, _MM_SHUFFLE(1, 1, 2, 2)),
+				_mm_shuffle_ps(v_c, v_c, _MM_SHUFFLE(3, 3, 0, 0)),
+				_MM_SHUFFLE(2, 0, 2, 0)
+			);
+
+			_mm_storeu_ps(red + x, _mm_min_ps(v_max, _mm_max_ps(v_min, _mm_mul_ps(v_r, v_factor))));
+			_mm_storeu_ps(green + x, _mm_min_ps(v_max, _mm_max_ps(v_min, _mm_mul_ps(v_g, v_factor))));
+			_mm_storeu_ps(blue + x, _mm_min_ps(v_max, _mm_max_ps(v_min, _mm_mul_ps(v_bl, v_factor))));
+		}
+	}
+
+	for (; x < width; ++x) {
+		image.setR(x, y, readSample(data + (x * 3) * sizeof(float), swap_bytes) * factor);
+		image.setG(x, y, readSample(data + (x * 3 + 1) * sizeof(float), swap_bytes) * factor);
+		image.setB(x, y, readSample(data + (x * 3 + 2) * sizeof(float), swap_bytes) * factor);
+	}
+}
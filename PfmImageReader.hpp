@@ -0,0 +1,48 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#pragma once
+
+#include <string>
+
+#include "ImageReader.hpp"
+#include "Image.hpp"
+
+// Portable float map: three interleaved 32b floats per pixel, rows stored
+// bottom to top, the sign of the scale giving the byte order. Samples are
+// multiplied by the absolute scale and 65535, then clamped like set*().
+class PfmImageReader :
+	public ImageReader
+{
+public:
+	PfmImageReader(Image::Precision _precision = Image::PRECISION_FLOAT);
+
+	void load(std::istream& stream, Image& image);
+	// Maps the file and deinterleaves little endian rows straight from the
+	// mapping into float planes, no intermediate row buffer
+	void loadFile(const std::string& path, Image& image);
+
+private:
+	void storeRow(const char* data, bool swap_bytes, float factor, Image& image, unsigned int y) const;
+
+	const Image::Precision precision;
+};
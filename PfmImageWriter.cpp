@@ -0,0 +1,74 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "PfmImageWriter.hpp"
+#include "Exception.hpp"
+#include "Image.hpp"
+
+namespace
+{
+
+	void writeSample(float value, bool swap_bytes, char* data)
+	{
+		if (swap_bytes) {
+			char bytes[sizeof(float)];
+			std::memcpy(bytes, &value, sizeof(float));
+			std::reverse_copy(bytes, bytes + sizeof(float), data);
+		} else {
+			std::memcpy(data, &value, sizeof(float));
+		}
+	}
+
+}
+
+void PfmImageWriter::save(const Image& image, std::ostream& stream)
+{
+	if (!stream) {
+		throw Exception("Bad stream.", __FILE__, __LINE__);
+	}
+	stream << "PF\n";
+	stream << image.getWidth() << " " << image.getHeight() << '\n';
+	stream << "-1.0\n";
+
+	const unsigned short probe = 1;
+	const bool swap_bytes = *reinterpret_cast<const unsigned char*>(&probe) != 1;
+	std::vector<char> row(static_cast<size_t>(image.getWidth()) * 3 * sizeof(float));
+
+	for (unsigned int y = image.getHeight(); y > 0; --y) {
+		char* data = row.empty() ? 0 : &row[0];
+		for (unsigned int x = 0; x < image.getWidth(); ++x) {
+			writeSample(image.getR(x, y - 1) / 65535.0f, swap_bytes, data);
+			writeSample(image.getG(x, y - 1) / 65535.0f, swap_bytes, data + sizeof(float));
+			writeSample(image.getB(x, y - 1) / 65535.0f, swap_bytes, data + 2 * sizeof(float));
+			data += 3 * sizeof(float);
+		}
+
+		if (!row.empty() && !stream.write(&row[0], row.size())) {
+			throw Exception("Bad stream.", __FILE__, __LINE__);
+		}
+	}
+}
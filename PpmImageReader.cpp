@@ -21,6 +21,7 @@
  */
 
 #include <istream>
+#include <vector>
 
 #include "PpmImageReader.hpp"
 #include "Exception.hpp"
@@ -103,6 +104,11 @@ namespace
 
 }
 
+PpmImageReader::PpmImageReader(Image::Precision _precision) :
+	precision(_precision)
+{
+}
+
 void PpmImageReader::load(std::istream& stream, Image& image)
 {
 	char c;
@@ -129,27 +135,41 @@ void PpmImageReader::load(std::istream& stream, Image& image)
 		|| !skipPnmSpace(stream)
 		|| !(stream >> max_value)
 		|| !skipPnmSpace(stream)
+		|| !max_value
+		|| max_value > 65535
 	) {
 		throw Exception("Malformed PPM image header.", __FILE__, __LINE__);
 	}
 
-	image.clearAndInitialize(width, height);
+	image.clearAndInitialize(width, height, false, precision);
+
+	const size_t sample_size = max_value > 255 ? 2 : 1;
+	std::vector<char> row(width * 3 * sample_size);
 
 	for (unsigned int y = 0; y < height; ++y) {
+		if (!row.empty() && !stream.read(&row[0], row.size())) {
+			throw Exception("Corrupt PPM image body.", __FILE__, __LINE__);
+		}
+
+		size_t index = 0;
 		for (unsigned int x = 0; x < width; ++x) {
 			for (unsigned int p = 0; p < 3; ++p) {
-				unsigned short value = 0;
-				if (!stream.get(c)) {
-					throw Exception("Corrupt PPM image body.", __FILE__, __LINE__);
-				}
-				value = static_cast<unsigned char>(c);
-				if (max_value > 255) {
+				unsigned short value = static_cast<unsigned char>(row[index]);
+				++index;
+				if (sample_size > 1) {
 					value <<= 8;
-					if (!stream.get(c)) {
-						throw Exception("Corrupt PPM image body.", __FILE__, __LINE__);
+					value |= static_cast<unsigned char>(row[index]);
+					++index;
+				}
+
+				if (precision == Image::PRECISION_U16) {
+					if (max_value != 65535) {
+						value = (static_cast<unsigned long>(value) * 65535 + max_value / 2) / max_value;
 					}
-					value |= static_cast<unsigned char>(c);
+					static_cast<unsigned short*>(image.getRow(p, y))[x] = value;
+					continue;
 				}
+
 				const float normalized_value = static_cast<float>(value) * 65535.0f / static_cast<float>(max_value);
 				switch (p) {
 					case 0: {
@@ -23,10 +23,17 @@
 #pragma once
 
 #include "ImageReader.hpp"
+#include "Image.hpp"
 
 class PpmImageReader :
 	public ImageReader
 {
 public:
+	// With PRECISION_U16 the samples are stored as read, scaled to 16b only if needed
+	PpmImageReader(Image::Precision _precision = Image::PRECISION_FLOAT);
+
 	void load(std::istream& stream, Image& image);
+
+private:
+	const Image::Precision precision;
 };
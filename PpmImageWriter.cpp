@@ -21,6 +21,7 @@
  */
 
 #include <iostream>
+#include <vector>
 
 #include "PpmImageWriter.hpp"
 #include "Exception.hpp"
@@ -44,37 +45,49 @@ void PpmImageWriter::save(const Image& image, std::ostream& stream)
 	} else {
 		stream << "65535\n";
 	}
+
+	std::vector<char> row(static_cast<size_t>(image.getWidth()) * 3 * (eight_bit ? 1 : 2));
+
 	for (unsigned int y = 0; y < image.getHeight(); ++y) {
+		size_t index = 0;
 		for (unsigned int x = 0; x < image.getWidth(); ++x) {
 			for (unsigned int p = 0; p < 3; ++p) {
 				unsigned short value = 0;
-				switch (p) {
-					case 0: {
-						value = image.getR(x, y);
-						break;
-					}
+				if (image.getPrecision() == Image::PRECISION_U16) {
+					// No float round trip for samples kept as read
+					value = static_cast<const unsigned short*>(image.getRow(p, y))[x];
+				} else {
+					switch (p) {
+						case 0: {
+							value = image.getR(x, y);
+							break;
+						}
 
-					case 1: {
-						value = image.getG(x, y);
-						break;
-					}
+						case 1: {
+							value = image.getG(x, y);
+							break;
+						}
 
-					case 2: {
-						value = image.getB(x, y);
-						break;
+						case 2: {
+							value = image.getB(x, y);
+							break;
+						}
 					}
 				}
 
 				if (eight_bit) {
-					stream << static_cast<char>(value >> 8);
+					row[index] = value >> 8;
+					++index;
 				} else {
-					stream << static_cast<char>(value >> 8) << static_cast<char>(value & 0xFF);
-				}
-
-				if (!stream) {
-					throw Exception("Bad stream.", __FILE__, __LINE__);
+					row[index] = value >> 8;
+					row[index + 1] = value & 0xFF;
+					index += 2;
 				}
 			}
 		}
+
+		if (!row.empty() && !stream.write(&row[0], row.size())) {
+			throw Exception("Bad stream.", __FILE__, __LINE__);
+		}
 	}
 }
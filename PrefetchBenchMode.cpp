@@ -0,0 +1,135 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+
+#include "PrefetchBenchMode.hpp"
+
+#include "Arguments.hpp"
+#include "Exception.hpp"
+#include "HaldClut.hpp"
+#include "Image.hpp"
+#include "PpmImageReader.hpp"
+#include "PrefetchClutMethod.hpp"
+#include "TestBench.hpp"
+#include "Timer.hpp"
+
+const char* PrefetchBenchMode::getName() const
+{
+	return "--prefetch";
+}
+
+const char* PrefetchBenchMode::getUsage() const
+{
+	return "INPUT [LEVELS] [DISTANCES] [CYCLES]";
+}
+
+unsigned int PrefetchBenchMode::getMinimumArgumentCount() const
+{
+	return 1;
+}
+
+void PrefetchBenchMode::run(const std::vector<std::string>& args)
+{
+	std::ifstream input_file(args[0].c_str());
+	Image input_image;
+	PpmImageReader().load(input_file, input_image);
+
+	std::vector<unsigned int> levels = getNumberList("4,8,12,16");
+	if (args.size() > 1) {
+		levels = getNumberList(args[1]);
+	}
+
+	std::vector<unsigned int> distances = getNumberList("0,1,2,4,8,16,32");
+	if (args.size() > 2) {
+		distances = getNumberList(args[2]);
+	}
+
+	unsigned int cycles = 3;
+	if (args.size() > 3) {
+		cycles = getNumber(args[3]);
+	}
+
+	const double pixels = static_cast<double>(input_image.getWidth()) * input_image.getHeight() * cycles;
+
+	// Distance 0 is the baseline, it runs the same row loop without prefetching
+	if (std::find(distances.begin(), distances.end(), 0) == distances.end()) {
+		distances.insert(distances.begin(), 0);
+	}
+
+	PrefetchClutMethod prefetch_clut_method;
+
+	for (std::vector<unsigned int>::const_iterator levels_it = levels.begin(); levels_it != levels.end(); ++levels_it) {
+		const unsigned int level = *levels_it;
+		if (level < 2) {
+			throw Exception("CLUT level must be at least 2.", __FILE__, __LINE__);
+		}
+
+		Image clut_image;
+		createIdentityHaldClut(level, clut_image);
+		TestBench test_bench(input_image, clut_image);
+		prefetch_clut_method.setClut(clut_image, level);
+
+		std::cout
+			<< std::endl
+			<< "Level "
+			<< level
+			<< " ("
+			<< (prefetch_clut_method.getClutFootprint() >> 10)
+			<< " KiB CLUT)"
+			<< std::endl
+			<< std::fixed
+			<< std::setprecision(2);
+
+		unsigned int best_distance = 0;
+		double best_nsecs = 0.0;
+		double no_prefetch_nsecs = 0.0;
+		for (std::vector<unsigned int>::const_iterator distances_it = distances.begin(); distances_it != distances.end(); ++distances_it) {
+			prefetch_clut_method.setDistance(*distances_it);
+			const double nsecs = test_bench.runRows(&prefetch_clut_method, cycles).getNSecs() / pixels;
+
+			if (distances_it == distances.begin() || nsecs < best_nsecs) {
+				best_distance = *distances_it;
+				best_nsecs = nsecs;
+			}
+			if (!*distances_it) {
+				no_prefetch_nsecs = nsecs;
+			}
+
+			std::cout
+				<< "  distance "
+				<< std::left
+				<< std::setw(4)
+				<< *distances_it
+				<< std::right
+				<< std::setw(8)
+				<< nsecs
+				<< " ns/pixel"
+				<< std::endl;
+		}
+
+		std::cout << "  best:    " << best_distance << " (" << no_prefetch_nsecs / best_nsecs << "x over no prefetching)" << std::endl;
+	}
+}
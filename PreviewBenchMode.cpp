@@ -0,0 +1,181 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+
+#include "PreviewBenchMode.hpp"
+
+#include "Arguments.hpp"
+#include "Conversion.hpp"
+#include "Exception.hpp"
+#include "HaldClut.hpp"
+#include "Image.hpp"
+#include "NearestClutMethod.hpp"
+#include "PpmImageReader.hpp"
+#include "SseClutMethod.hpp"
+#include "Timer.hpp"
+
+namespace
+{
+
+	double getLatency(const ClutMethod& clut_method, const Image& input_image, Image& output_image, unsigned int factor, PreviewFilter filter, unsigned int cycles)
+	{
+		Timer timer;
+		for (unsigned int cycle = 0; cycle < cycles; ++cycle) {
+			if (factor > 1) {
+				convertPreview(clut_method, input_image, output_image, factor, filter);
+			} else {
+				convertImage(clut_method, input_image, output_image);
+			}
+		}
+		timer.stop();
+		return static_cast<double>(timer.getUSecs()) / 1000.0 / cycles;
+	}
+
+	unsigned int getMaxDifference(const Image& image, const Image& other)
+	{
+		const Image::Difference difference = image.compare(other);
+		return std::max(difference.max_r, std::max(difference.max_g, difference.max_b));
+	}
+
+}
+
+const char* PreviewBenchMode::getName() const
+{
+	return "--preview";
+}
+
+const char* PreviewBenchMode::getUsage() const
+{
+	return "INPUT CLUT [FACTORS] [CYCLES]";
+}
+
+unsigned int PreviewBenchMode::getMinimumArgumentCount() const
+{
+	return 2;
+}
+
+void PreviewBenchMode::run(const std::vector<std::string>& args)
+{
+	std::ifstream input_file(args[0].c_str());
+	Image input_image;
+	PpmImageReader().load(input_file, input_image);
+
+	std::ifstream clut_file(args[1].c_str());
+	Image clut_image;
+	PpmImageReader().load(clut_file, clut_image);
+
+	const unsigned int level = getHaldClutLevel(clut_image);
+	if (level < 2) {
+		throw Exception("CLUT image has wrong dimensions.", __FILE__, __LINE__);
+	}
+
+	std::vector<unsigned int> factors = getNumberList("4,8");
+	if (args.size() > 2) {
+		factors = getNumberList(args[2]);
+	}
+
+	unsigned int cycles = 10;
+	if (args.size() > 3) {
+		cycles = getNumber(args[3]);
+	}
+
+	SseClutMethod sse_clut_method;
+	sse_clut_method.setClut(clut_image, level);
+	NearestClutMethod nearest_clut_method;
+	nearest_clut_method.setClut(clut_image, level);
+
+	Image output_image;
+	std::cout
+		<< "Full size:  "
+		<< input_image.getWidth()
+		<< 'x'
+		<< input_image.getHeight()
+		<< " in "
+		<< std::fixed
+		<< std::setprecision(2)
+		<< getLatency(sse_clut_method, input_image, output_image, 1, PREVIEW_BOX, cycles)
+		<< "ms"
+		<< std::endl;
+
+	const char* const filter_names[] = {
+		"box",
+		"bilinear"
+	};
+
+	for (std::vector<unsigned int>::const_iterator factors_it = factors.begin(); factors_it != factors.end(); ++factors_it) {
+		const unsigned int factor = *factors_it;
+		if (factor < 2) {
+			throw Exception("Preview factor must be at least 2.", __FILE__, __LINE__);
+		}
+
+		std::cout
+			<< std::endl
+			<< "Factor "
+			<< factor
+			<< " ("
+			<< (input_image.getWidth() + factor - 1) / factor
+			<< 'x'
+			<< (input_image.getHeight() + factor - 1) / factor
+			<< " preview)"
+			<< std::endl;
+		std::cout << "  filter      method     latency  difference" << std::endl;
+
+		for (unsigned int filter = PREVIEW_BOX; filter <= PREVIEW_BILINEAR; ++filter) {
+			Image interpolated_image;
+			const double interpolated_latency = getLatency(sse_clut_method, input_image, interpolated_image, factor, static_cast<PreviewFilter>(filter), cycles);
+			Image nearest_image;
+			const double nearest_latency = getLatency(nearest_clut_method, input_image, nearest_image, factor, static_cast<PreviewFilter>(filter), cycles);
+
+			std::cout
+				<< "  "
+				<< std::left
+				<< std::setw(12)
+				<< filter_names[filter]
+				<< std::setw(8)
+				<< sse_clut_method.getFilename()
+				<< std::right
+				<< std::setw(8)
+				<< interpolated_latency
+				<< "ms"
+				<< std::setw(12)
+				<< 0
+				<< std::endl
+				<< "  "
+				<< std::left
+				<< std::setw(12)
+				<< filter_names[filter]
+				<< std::setw(8)
+				<< nearest_clut_method.getFilename()
+				<< std::right
+				<< std::setw(8)
+				<< nearest_latency
+				<< "ms"
+				<< std::setw(12)
+				<< getMaxDifference(interpolated_image, nearest_image)
+				<< std::endl;
+		}
+	}
+}
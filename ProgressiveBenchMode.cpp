@@ -0,0 +1,161 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "ProgressiveBenchMode.hpp"
+
+#include "Arguments.hpp"
+#include "Conversion.hpp"
+#include "Exception.hpp"
+#include "HaldClut.hpp"
+#include "Image.hpp"
+#include "ImageFormats.hpp"
+#include "SseClutMethod.hpp"
+#include "Timer.hpp"
+
+namespace
+{
+
+	// Accumulates the time from the start of the conversion to each pass
+	class PassTimes :
+		public ProgressiveCallback
+	{
+	public:
+		void start()
+		{
+			pass = 0;
+			timer.start();
+		}
+
+		bool passDone(unsigned int step, const Image& output_image)
+		{
+			timer.stop();
+			if (pass >= nsecs.size()) {
+				nsecs.push_back(0);
+				steps.push_back(step);
+			}
+			nsecs[pass] += timer.getNSecs();
+			++pass;
+			return true;
+		}
+
+		std::vector<unsigned long long> nsecs;
+		std::vector<unsigned int> steps;
+
+	private:
+		Timer timer;
+		size_t pass;
+	};
+
+}
+
+const char* ProgressiveBenchMode::getName() const
+{
+	return "--progressive";
+}
+
+const char* ProgressiveBenchMode::getUsage() const
+{
+	return "INPUT CLUT [FIRST_STEP] [CYCLES]";
+}
+
+unsigned int ProgressiveBenchMode::getMinimumArgumentCount() const
+{
+	return 2;
+}
+
+void ProgressiveBenchMode::run(const std::vector<std::string>& args)
+{
+	Image input_image;
+	loadImage(args[0], input_image);
+
+	Image clut_image;
+	loadImage(args[1], clut_image);
+
+	const unsigned int level = getHaldClutLevel(clut_image);
+	if (level < 2) {
+		throw Exception("CLUT image has wrong dimensions.", __FILE__, __LINE__);
+	}
+
+	unsigned int first_step = 8;
+	if (args.size() > 2) {
+		first_step = getNumber(args[2]);
+	}
+
+	unsigned int cycles = 10;
+	if (args.size() > 3) {
+		cycles = std::max(1u, getNumber(args[3]));
+	}
+
+	SseClutMethod clut_method;
+	clut_method.setClut(clut_image, level);
+
+	Image raster_image;
+	Timer raster_timer;
+	for (unsigned int cycle = 0; cycle < cycles; ++cycle) {
+		convertRows(clut_method, input_image, raster_image);
+	}
+	raster_timer.stop();
+
+	Image progressive_image;
+	PassTimes pass_times;
+	for (unsigned int cycle = 0; cycle < cycles; ++cycle) {
+		pass_times.start();
+		convertProgressive(clut_method, input_image, progressive_image, &pass_times, first_step);
+	}
+
+	const double raster_msecs = static_cast<double>(raster_timer.getNSecs()) / 1.0e6 / cycles;
+	std::cout << "Raster:     " << raster_msecs << "ms (convertRows)" << std::endl;
+	for (size_t pass = 0; pass < pass_times.nsecs.size(); ++pass) {
+		const double msecs = static_cast<double>(pass_times.nsecs[pass]) / 1.0e6 / cycles;
+		std::cout
+			<< "Step "
+			<< pass_times.steps[pass]
+			<< ":     "
+			<< msecs
+			<< "ms ("
+			<< msecs / raster_msecs * 100.0
+			<< "% of raster)"
+			<< std::endl;
+	}
+
+	if (!pass_times.nsecs.empty()) {
+		const double total_msecs = static_cast<double>(pass_times.nsecs.back()) / 1.0e6 / cycles;
+		std::cout << "Overhead:   " << (total_msecs / raster_msecs - 1.0) * 100.0 << '%' << std::endl;
+	}
+
+	const Image::Difference difference = raster_image.compare(progressive_image);
+	std::cout
+		<< "Difference: "
+		<< difference.absolute
+		<< " (Rmax "
+		<< difference.max_r
+		<< ", Gmax "
+		<< difference.max_g
+		<< ", Bmax "
+		<< difference.max_b
+		<< ')'
+		<< std::endl;
+}
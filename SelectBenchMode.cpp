@@ -0,0 +1,110 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <iomanip>
+#include <iostream>
+
+#include "SelectBenchMode.hpp"
+
+#include "Arguments.hpp"
+#include "Exception.hpp"
+#include "HaldClut.hpp"
+#include "Image.hpp"
+#include "ImageFormats.hpp"
+#include "KernelSelection.hpp"
+
+const char* SelectBenchMode::getName() const
+{
+	return "--select";
+}
+
+const char* SelectBenchMode::getUsage() const
+{
+	return "INPUT CLUT [TOLERANCE] [CYCLES] [CHOICES]";
+}
+
+unsigned int SelectBenchMode::getMinimumArgumentCount() const
+{
+	return 2;
+}
+
+void SelectBenchMode::run(const std::vector<std::string>& args)
+{
+	Image clut_image;
+	loadImage(args[1], clut_image);
+
+	const unsigned int level = getHaldClutLevel(clut_image);
+	if (level < 2) {
+		throw Exception("CLUT image has wrong dimensions.", __FILE__, __LINE__);
+	}
+
+	// One 8b step
+	unsigned int tolerance = 257;
+	if (args.size() > 2) {
+		tolerance = getNumber(args[2]);
+	}
+
+	unsigned int cycles = 3;
+	if (args.size() > 3) {
+		cycles = getNumber(args[3]);
+	}
+
+	const std::string path = args.size() > 4 ? args[4] : KernelChoices::getDefaultPath();
+	const std::string machine = KernelChoices::getMachine();
+
+	KernelChoices kernel_choices(path);
+	std::string kernel;
+	if (kernel_choices.find(machine, level, tolerance, kernel)) {
+		std::cout << "Stored choice for level " << level << " within " << tolerance << ": " << kernel << " (" << path << ")" << std::endl;
+		return;
+	}
+
+	Image input_image;
+	loadImage(args[0], input_image);
+
+	const std::vector<KernelMeasurement> measurements = measureKernels(input_image, clut_image, level, cycles);
+	const KernelMeasurement& selected = selectKernel(measurements, tolerance);
+
+	std::cout << "Machine: " << machine << std::endl << std::endl;
+	for (std::vector<KernelMeasurement>::const_iterator measurements_it = measurements.begin(); measurements_it != measurements.end(); ++measurements_it) {
+		std::cout
+			<< std::left
+			<< std::setw(11)
+			<< measurements_it->name
+			<< std::right
+			<< std::setw(9)
+			<< std::fixed
+			<< std::setprecision(3)
+			<< static_cast<double>(measurements_it->nsecs) / 1000000.0
+			<< "ms  error "
+			<< std::setw(5)
+			<< measurements_it->max_error
+			<< (measurements_it->max_error > tolerance ? "  over budget" : "")
+			<< (&*measurements_it == &selected ? "  selected" : "")
+			<< std::endl;
+	}
+
+	kernel_choices.set(machine, level, tolerance, selected.name);
+	kernel_choices.save();
+
+	std::cout << std::endl << "Stored choice for level " << level << " within " << tolerance << ": " << selected.name << " (" << path << ")" << std::endl;
+}
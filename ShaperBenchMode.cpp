@@ -0,0 +1,152 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+
+#include "ShaperBenchMode.hpp"
+
+#include "Exception.hpp"
+#include "Image.hpp"
+#include "PpmImageReader.hpp"
+#include "ShaperClutMethod.hpp"
+#include "SseClutMethod.hpp"
+#include "TestBench.hpp"
+#include "Timer.hpp"
+#include "ToneCurve.hpp"
+
+namespace
+{
+
+	const unsigned int cycles = 3;
+
+	// Returns null for "none"
+	ToneCurve* createToneCurve(const std::string& name)
+	{
+		if (name == "none") {
+			return 0;
+		}
+		if (name == "srgb-encode") {
+			return new ToneCurve(ToneCurve::createSrgbEncoding());
+		}
+		if (name == "srgb-decode") {
+			return new ToneCurve(ToneCurve::createSrgbDecoding());
+		}
+		std::ifstream file(name.c_str());
+		if (!file) {
+			throw Exception("Can't open tone curve '" + name + "'.", __FILE__, __LINE__);
+		}
+		return new ToneCurve(ToneCurve::load(file));
+	}
+
+}
+
+const char* ShaperBenchMode::getName() const
+{
+	return "--shaper";
+}
+
+const char* ShaperBenchMode::getUsage() const
+{
+	return "INPUT CLUT [INPUT_CURVE OUTPUT_CURVE]";
+}
+
+unsigned int ShaperBenchMode::getMinimumArgumentCount() const
+{
+	return 2;
+}
+
+void ShaperBenchMode::run(const std::vector<std::string>& args)
+{
+	std::ifstream input_file(args[0].c_str());
+	Image input_image;
+	PpmImageReader().load(input_file, input_image);
+	std::ifstream clut_file(args[1].c_str());
+	Image clut_image;
+	PpmImageReader().load(clut_file, clut_image);
+
+	ToneCurve* input_curve = 0;
+	ToneCurve* output_curve = 0;
+
+	try {
+		// HaldCLUTs are gamma encoded, while the image data is linear
+		input_curve = createToneCurve(args.size() > 3 ? args[2] : "srgb-encode");
+		output_curve = createToneCurve(args.size() > 3 ? args[3] : "srgb-decode");
+
+		// Separate passes: Curve, CLUT, curve
+		SseClutMethod sse_clut_method;
+		unsigned long long separate_nsecs = 0;
+		Image separate_output_image;
+		for (unsigned int cycle = 0; cycle < cycles; ++cycle) {
+			Image shaped_image = input_image;
+			Timer input_curve_timer;
+			if (input_curve) {
+				input_curve->apply(shaped_image);
+			}
+			input_curve_timer.stop();
+
+			TestBench test_bench(shaped_image, clut_image);
+			const Timer clut_timer = test_bench.run(&sse_clut_method, 1);
+
+			separate_output_image = test_bench.getOutputImage();
+			Timer output_curve_timer;
+			if (output_curve) {
+				output_curve->apply(separate_output_image);
+			}
+			output_curve_timer.stop();
+
+			separate_nsecs += input_curve_timer.getNSecs() + clut_timer.getNSecs() + output_curve_timer.getNSecs();
+		}
+
+		// Fused: One pass
+		ShaperClutMethod shaper_clut_method;
+		shaper_clut_method.setCurves(input_curve, output_curve);
+		TestBench test_bench(input_image, clut_image);
+		const unsigned long long fused_nsecs = test_bench.run(&shaper_clut_method, cycles).getNSecs();
+
+		const Image::Difference difference = separate_output_image.compare(test_bench.getOutputImage());
+
+		std::cout << "Separate:   " << separate_nsecs / cycles / 1000000 << "ms" << std::endl;
+		std::cout << "Fused:      " << fused_nsecs / cycles / 1000000 << "ms" << std::endl;
+		std::cout << "Speedup:    " << static_cast<float>(separate_nsecs) / static_cast<float>(std::max(1ull, fused_nsecs)) << std::endl;
+		std::cout
+			<< "Difference: "
+			<< difference.absolute
+			<< " (Rmax "
+			<< difference.max_r
+			<< ", Gmax "
+			<< difference.max_g
+			<< ", Bmax "
+			<< difference.max_b
+			<< ')'
+			<< std::endl;
+	}
+	catch (...) {
+		delete output_curve;
+		delete input_curve;
+		throw;
+	}
+
+	delete output_curve;
+	delete input_curve;
+}
@@ -0,0 +1,55 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include "ShaperClutMethod.hpp"
+
+ShaperClutMethod::ShaperClutMethod() :
+	input_curve(0),
+	output_curve(0)
+{
+}
+
+const char* ShaperClutMethod::getDescription() const
+{
+	return "Integer clut storage with SSE and fused 1D curves";
+}
+
+const char* ShaperClutMethod::getFilename() const
+{
+	return "shaper";
+}
+
+void ShaperClutMethod::setCurves(const ToneCurve* _input_curve, const ToneCurve* _output_curve)
+{
+	input_curve = _input_curve;
+	output_curve = _output_curve;
+}
+
+void ShaperClutMethod::convert(float* rgb) const
+{
+	convertShaped(rgb, input_curve, output_curve);
+}
+
+bool ShaperClutMethod::locateCell(const float* rgb, ClutCell& cell) const
+{
+	return !input_curve && !output_curve && SseClutMethod::locateCell(rgb, cell);
+}
@@ -0,0 +1,48 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#pragma once
+
+#include "SseClutMethod.hpp"
+
+// The SSE method with optional 1D curves before and after the lookup, kept in registers
+class ShaperClutMethod :
+	public SseClutMethod
+{
+public:
+	ShaperClutMethod();
+
+	const char* getDescription() const;
+	const char* getFilename() const;
+
+	// Either curve may be null, the curves must outlive the method
+	void setCurves(const ToneCurve* _input_curve, const ToneCurve* _output_curve);
+
+	void convert(float* rgb) const;
+
+	// The phases are only split without curves
+	bool locateCell(const float* rgb, ClutCell& cell) const;
+
+private:
+	const ToneCurve* input_curve;
+	const ToneCurve* output_curve;
+};
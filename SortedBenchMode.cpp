@@ -0,0 +1,156 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+
+#include "SortedBenchMode.hpp"
+
+#include "Arguments.hpp"
+#include "ClutMethod.hpp"
+#include "ClutMethods.hpp"
+#include "Exception.hpp"
+#include "HaldClut.hpp"
+#include "Image.hpp"
+#include "PpmImageReader.hpp"
+#include "TestBench.hpp"
+#include "Timer.hpp"
+
+namespace
+{
+
+	void printNSecs(double nsecs)
+	{
+		std::cout << std::setw(10) << std::fixed << std::setprecision(2) << nsecs;
+	}
+
+}
+
+const char* SortedBenchMode::getName() const
+{
+	return "--sorted";
+}
+
+const char* SortedBenchMode::getUsage() const
+{
+	return "INPUT [LEVELS] [CYCLES]";
+}
+
+unsigned int SortedBenchMode::getMinimumArgumentCount() const
+{
+	return 1;
+}
+
+void SortedBenchMode::run(const std::vector<std::string>& args)
+{
+	std::ifstream input_file(args[0].c_str());
+	Image input_image;
+	PpmImageReader().load(input_file, input_image);
+
+	std::vector<unsigned int> levels = getNumberList("2-16");
+	if (args.size() > 1) {
+		levels = getNumberList(args[1]);
+	}
+
+	unsigned int cycles = 3;
+	if (args.size() > 2) {
+		cycles = getNumber(args[2]);
+	}
+
+	const double pixels = std::max(1.0, static_cast<double>(input_image.getWidth()) * input_image.getHeight() * cycles);
+
+	const std::vector<ClutMethod*> clut_methods = createClutMethods();
+
+	try {
+		// Lowest level from which on sorting paid off at every level, 0 if it didn't at the last one
+		std::vector<unsigned int> break_even_levels(clut_methods.size(), 0);
+
+		std::cout << "All times in ns/pixel" << std::endl;
+
+		for (std::vector<unsigned int>::const_iterator levels_it = levels.begin(); levels_it != levels.end(); ++levels_it) {
+			const unsigned int level = *levels_it;
+			if (level < 2) {
+				throw Exception("CLUT level must be at least 2.", __FILE__, __LINE__);
+			}
+
+			Image clut_image;
+			createIdentityHaldClut(level, clut_image);
+			TestBench test_bench(input_image, clut_image);
+
+			std::cout
+				<< std::endl
+				<< "Level "
+				<< level
+				<< " ("
+				<< clut_image.getWidth()
+				<< 'x'
+				<< clut_image.getHeight()
+				<< " CLUT)"
+				<< std::endl
+				<< "  method                  raster      sort    sorted     total      gain"
+				<< std::endl;
+
+			for (std::vector<ClutMethod*>::size_type method = 0; method < clut_methods.size(); ++method) {
+				ClutMethod* const clut_method = clut_methods[method];
+
+				const double raster = static_cast<double>(test_bench.run(clut_method, cycles).getNSecs()) / pixels;
+				const TestBench::SortedTimes sorted_times = test_bench.runSorted(clut_method, cycles);
+				const double sort = static_cast<double>(sorted_times.sort_nsecs) / pixels;
+				const double sorted = static_cast<double>(sorted_times.convert_nsecs) / pixels;
+
+				std::cout << "  " << std::left << std::setw(20) << clut_method->getFilename() << std::right;
+				printNSecs(raster);
+				printNSecs(sort);
+				printNSecs(sorted);
+				printNSecs(sort + sorted);
+				printNSecs(raster - sort - sorted);
+				std::cout << std::endl;
+
+				if (sort + sorted < raster) {
+					if (!break_even_levels[method]) {
+						break_even_levels[method] = level;
+					}
+				} else {
+					break_even_levels[method] = 0;
+				}
+			}
+		}
+
+		std::cout << std::endl;
+		for (std::vector<ClutMethod*>::size_type method = 0; method < clut_methods.size(); ++method) {
+			std::cout << "Break-even: " << std::left << std::setw(12) << clut_methods[method]->getFilename() << std::right;
+			if (break_even_levels[method]) {
+				std::cout << "level " << break_even_levels[method] << std::endl;
+			} else {
+				std::cout << "not reached" << std::endl;
+			}
+		}
+	}
+	catch (...) {
+		destroyClutMethods(clut_methods);
+		throw;
+	}
+
+	destroyClutMethods(clut_methods);
+}
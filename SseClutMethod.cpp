@@ -22,10 +22,11 @@
 
 #include <algorithm>
 
-#include <xmmintrin.h>
-
 #include "SseClutMethod.hpp"
 
+#include "Memory.hpp"
+#include "ToneCurve.hpp"
+
 namespace
 {
 
@@ -40,16 +41,28 @@ namespace
 		return _mm_cvtpu16_ps(*reinterpret_cast<const __m64*>(clut_image + index));
 	}
 
+	// Per lane without going through memory, the fourth lane becomes 0
+	inline __m128 applyCurve(const ToneCurve& curve, __m128 v_value)
+	{
+		const float red = curve.apply(_mm_cvtss_f32(v_value));
+		const float green = curve.apply(_mm_cvtss_f32(_mm_shuffle_ps(v_value, v_value, 0x55)));
+		const float blue = curve.apply(_mm_cvtss_f32(_mm_shuffle_ps(v_value, v_value, 0xAA)));
+		return _mm_set_ps(0.0f, blue, green, red);
+	}
+
 }
 
 SseClutMethod::SseClutMethod() :
-	clut_image(0)
+	clut_storage(0),
+	clut_image(0),
+	clut_level(0),
+	strength(1.0f)
 {
 }
 
 SseClutMethod::~SseClutMethod()
 {
-	_mm_free(clut_image);
+	freeMemory(clut_storage);
 }
 
 const char* SseClutMethod::getDescription() const
@@ -64,39 +77,69 @@ const char* SseClutMethod::getFilename() const
 
 void SseClutMethod::setClut(const Image& image, unsigned int level)
 {
-	_mm_free(clut_image);
-	const size_t size = image.getWidth() * image.getHeight();
-	clut_image = reinterpret_cast<unsigned short*>(_mm_malloc(size * 4 * sizeof(unsigned short), 4 * sizeof(unsigned short)));
+	freeMemory(clut_storage);
+	const size_t size = static_cast<size_t>(image.getWidth()) * image.getHeight();
+	clut_storage = reinterpret_cast<unsigned short*>(allocateMemory(size * 4 * sizeof(unsigned short), 4 * sizeof(unsigned short)));
 	size_t index = 0;
 	for (unsigned int y = 0; y < image.getHeight(); ++y) {
 		for (unsigned int x = 0; x < image.getWidth(); ++x) {
-			clut_image[index] = image.getR(x, y);
+			clut_storage[index] = image.getR(x, y);
 			++index;
-			clut_image[index] = image.getG(x, y);
+			clut_storage[index] = image.getG(x, y);
 			++index;
-			clut_image[index] = image.getB(x, y);
+			clut_storage[index] = image.getB(x, y);
 			index += 2;
 		}
 	}
 
+	clut_image = clut_storage;
+
 	clut_level = level * level;
 	flevel_minus_one = static_cast<float>(clut_level - 1) / 65535.0f;
 	flevel_minus_two = static_cast<float>(clut_level - 2);
 }
 
-void SseClutMethod::convert(float* rgb) const
+bool SseClutMethod::setPackedClut(const unsigned short* packed_clut, unsigned int level)
+{
+	freeMemory(clut_storage);
+	clut_storage = 0;
+
+	clut_image = packed_clut;
+
+	clut_level = level * level;
+	flevel_minus_one = static_cast<float>(clut_level - 1) / 65535.0f;
+	flevel_minus_two = static_cast<float>(clut_level - 2);
+
+	return true;
+}
+
+inline void SseClutMethod::locate(const float* rgb, ClutCell& cell) const
+{
+	locate(_mm_load_ps(rgb), cell);
+}
+
+inline void SseClutMethod::locate(__m128 v_rgb, ClutCell& cell) const
 {
 	const unsigned int level = clut_level; // This is important
 
-	const unsigned int red = std::min(flevel_minus_two, rgb[0] * flevel_minus_one);
-	const unsigned int green = std::min(flevel_minus_two, rgb[1] * flevel_minus_one);
-	const unsigned int blue = std::min(flevel_minus_two, rgb[2] * flevel_minus_one);
+	const __m128 v_position = v_rgb * _mm_load_ps1(&flevel_minus_one);
+
+	const unsigned int red = std::min(flevel_minus_two, _mm_cvtss_f32(v_position));
+	const unsigned int green = std::min(flevel_minus_two, _mm_cvtss_f32(_mm_shuffle_ps(v_position, v_position, 0x55)));
+	const unsigned int blue = std::min(flevel_minus_two, _mm_cvtss_f32(_mm_shuffle_ps(v_position, v_position, 0xAA)));
 
-	const __m128 v_rgb = _mm_load_ps(rgb) *_mm_load_ps1(&flevel_minus_one) - _mm_set_ps(0.0f, blue, green, red);
+	_mm_store_ps(cell.fraction, v_position - _mm_set_ps(0.0f, blue, green, red));
 
+	cell.color = red + green * level + blue * level * level;
+}
+
+inline __m128 SseClutMethod::lookup(const ClutCell& cell) const
+{
+	const unsigned int level = clut_level; // This is important
 	const unsigned int level_square = level * level;
 
-	const unsigned int color = red + green * level + blue * level_square;
+	const unsigned int color = cell.color;
+	const __m128 v_rgb = _mm_load_ps(cell.fraction);
 
 	size_t index[2];
 	posToIndex(color, index);
@@ -128,5 +171,91 @@ void SseClutMethod::convert(float* rgb) const
 	const __m128 v_b = _mm_shuffle_ps(v_rgb, v_rgb, 0xAA);
 	const __m128 v_one_minus_b = _mm_set_ps1(1.0f) - v_b;
 
-	_mm_store_ps(rgb, v_out * v_one_minus_b + v_tmp1 * v_b);
+	return v_out * v_one_minus_b + v_tmp1 * v_b;
+}
+
+inline void SseClutMethod::interpolate(const ClutCell& cell, float* rgb) const
+{
+	__m128 v_out = lookup(cell);
+
+	if (strength != 1.0f) {
+		const __m128 v_in = _mm_load_ps(rgb);
+		v_out = v_in + _mm_load_ps1(&strength) * (v_out - v_in);
+	}
+
+	_mm_store_ps(rgb, v_out);
+}
+
+void SseClutMethod::convert(float* rgb) const
+{
+	ClutCell cell;
+	locate(rgb, cell);
+	interpolate(cell, rgb);
+}
+
+bool SseClutMethod::locateCell(const float* rgb, ClutCell& cell) const
+{
+	locate(rgb, cell);
+	return true;
+}
+
+void SseClutMethod::interpolateCell(const ClutCell& cell, float* rgb) const
+{
+	interpolate(cell, rgb);
+}
+
+void SseClutMethod::convertRowPrefetched(float* rgb, size_t count, unsigned int distance) const
+{
+	const size_t level = clut_level;
+	const size_t level_square = level * level;
+	const char* const clut = reinterpret_cast<const char*>(clut_image);
+
+	for (size_t pixel = 0; pixel < count; ++pixel) {
+		if (distance && pixel + distance < count) {
+			ClutCell ahead;
+			locate(rgb + (pixel + distance) * 4, ahead);
+
+			// Each pair of corners along red is 16 bytes, so one line per pair mostly suffices
+			_mm_prefetch(clut + ahead.color * 4 * sizeof(unsigned short), _MM_HINT_T0);
+			_mm_prefetch(clut + (ahead.color + level) * 4 * sizeof(unsigned short), _MM_HINT_T0);
+			_mm_prefetch(clut + (ahead.color + level_square) * 4 * sizeof(unsigned short), _MM_HINT_T0);
+			_mm_prefetch(clut + (ahead.color + level + level_square) * 4 * sizeof(unsigned short), _MM_HINT_T0);
+		}
+
+		ClutCell cell;
+		locate(rgb + pixel * 4, cell);
+		interpolate(cell, rgb + pixel * 4);
+	}
+}
+
+void SseClutMethod::convertShaped(float* rgb, const ToneCurve* input_curve, const ToneCurve* output_curve) const
+{
+	const __m128 v_in = _mm_load_ps(rgb);
+
+	ClutCell cell;
+	locate(input_curve ? applyCurve(*input_curve, v_in) : v_in, cell);
+
+	__m128 v_out = lookup(cell);
+	if (output_curve) {
+		v_out = applyCurve(*output_curve, v_out);
+	}
+
+	if (strength != 1.0f) {
+		v_out = v_in + _mm_load_ps1(&strength) * (v_out - v_in);
+	}
+
+	_mm_store_ps(rgb, v_out);
+}
+
+void SseClutMethod::setStrength(float _strength)
+{
+	strength = _strength;
+}
+
+size_t SseClutMethod::getClutFootprint() const
+{
+	if (!clut_image) {
+		return 0;
+	}
+	return static_cast<size_t>(clut_level) * clut_level * clut_level * 4 * sizeof(unsigned short);
 }
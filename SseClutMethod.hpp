@@ -22,9 +22,13 @@
 
 #pragma once
 
+#include <xmmintrin.h>
+
 #include "ClutMethod.hpp"
 #include "Image.hpp"
 
+class ToneCurve;
+
 class SseClutMethod :
 	public ClutMethod
 {
@@ -36,11 +40,33 @@ public:
 	const char* getFilename() const;
 
 	void setClut(const Image& image, unsigned int level);
+	bool setPackedClut(const unsigned short* packed_clut, unsigned int level);
 	void convert(float* rgb) const;
+	void setStrength(float _strength);
+
+	size_t getClutFootprint() const;
+
+	bool locateCell(const float* rgb, ClutCell& cell) const;
+	void interpolateCell(const ClutCell& cell, float* rgb) const;
+
+protected:
+	// Converts like convert() while prefetching the corners of the pixel distance ahead, 0 disables prefetching
+	void convertRowPrefetched(float* rgb, size_t count, unsigned int distance) const;
+	// Converts like convert() with 1D curves applied in registers before and after the lookup, either may be null
+	void convertShaped(float* rgb, const ToneCurve* input_curve, const ToneCurve* output_curve) const;
 
 private:
-	unsigned short* clut_image;
+	// Inlined so convert() does not pay for the split
+	void locate(const float* rgb, ClutCell& cell) const __attribute__((always_inline));
+	void locate(__m128 v_rgb, ClutCell& cell) const __attribute__((always_inline));
+	// Without the strength blending
+	__m128 lookup(const ClutCell& cell) const __attribute__((always_inline));
+	void interpolate(const ClutCell& cell, float* rgb) const __attribute__((always_inline));
+
+	unsigned short* clut_storage;
+	const unsigned short* clut_image;
 	unsigned int clut_level;
 	float flevel_minus_one;
 	float flevel_minus_two;
+	float strength;
 };
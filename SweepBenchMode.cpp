@@ -0,0 +1,174 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+
+#include "SweepBenchMode.hpp"
+
+#include "Arguments.hpp"
+#include "ClutMethod.hpp"
+#include "ClutMethods.hpp"
+#include "Exception.hpp"
+#include "HaldClut.hpp"
+#include "Image.hpp"
+#include "PpmImageReader.hpp"
+#include "SystemInfo.hpp"
+#include "TestBench.hpp"
+#include "Timer.hpp"
+
+namespace
+{
+
+	std::string formatBytes(size_t bytes)
+	{
+		std::ostringstream res;
+		if (bytes >= (10 << 20)) {
+			res << (bytes >> 20) << " MiB";
+		} else if (bytes >= (10 << 10)) {
+			res << (bytes >> 10) << " KiB";
+		} else {
+			res << bytes << " B";
+		}
+		return res.str();
+	}
+
+	std::string getCachePlacement(const SystemInfo& system_info, size_t footprint)
+	{
+		for (unsigned int level = 1; level < 4; ++level) {
+			const size_t cache_size = system_info.getCacheSize(level);
+			if (cache_size && footprint <= cache_size) {
+				std::ostringstream res;
+				res << 'L' << level;
+				return res.str();
+			}
+		}
+		return "RAM";
+	}
+
+}
+
+const char* SweepBenchMode::getName() const
+{
+	return "--sweep";
+}
+
+const char* SweepBenchMode::getUsage() const
+{
+	return "INPUT [LEVELS] [CYCLES]";
+}
+
+unsigned int SweepBenchMode::getMinimumArgumentCount() const
+{
+	return 1;
+}
+
+void SweepBenchMode::run(const std::vector<std::string>& args)
+{
+	std::ifstream input_file(args[0].c_str());
+	Image input_image;
+	PpmImageReader().load(input_file, input_image);
+
+	std::vector<unsigned int> levels = getNumberList("2-16");
+	if (args.size() > 1) {
+		levels = getNumberList(args[1]);
+	}
+
+	unsigned int cycles = 3;
+	if (args.size() > 2) {
+		cycles = getNumber(args[2]);
+	}
+
+	const SystemInfo system_info;
+	std::cout << "Caches:    ";
+	for (unsigned int level = 1; level < 4; ++level) {
+		std::cout << (level > 1 ? ", L" : " L") << level << ' ';
+		if (system_info.getCacheSize(level)) {
+			std::cout << formatBytes(system_info.getCacheSize(level));
+		} else {
+			std::cout << "unknown";
+		}
+	}
+	std::cout << std::endl;
+
+	const unsigned long long pixels = static_cast<unsigned long long>(input_image.getWidth()) * input_image.getHeight() * cycles;
+
+	const std::vector<ClutMethod*> clut_methods = createClutMethods();
+
+	try {
+		for (std::vector<unsigned int>::const_iterator levels_it = levels.begin(); levels_it != levels.end(); ++levels_it) {
+			const unsigned int level = *levels_it;
+			if (level < 2) {
+				throw Exception("CLUT level must be at least 2.", __FILE__, __LINE__);
+			}
+
+			Image clut_image;
+			createIdentityHaldClut(level, clut_image);
+			TestBench test_bench(input_image, clut_image);
+
+			std::cout
+				<< std::endl
+				<< "Level "
+				<< level
+				<< " ("
+				<< clut_image.getWidth()
+				<< 'x'
+				<< clut_image.getHeight()
+				<< " CLUT)"
+				<< std::endl;
+
+			for (std::vector<ClutMethod*>::const_iterator clut_methods_it = clut_methods.begin(); clut_methods_it != clut_methods.end(); ++clut_methods_it) {
+				ClutMethod* const clut_method = *clut_methods_it;
+
+				const Timer timer = test_bench.run(clut_method, cycles);
+				const size_t footprint = clut_method->getClutFootprint();
+
+				std::cout
+					<< "  "
+					<< std::left
+					<< std::setw(12)
+					<< clut_method->getFilename()
+					<< std::right
+					<< std::setw(12)
+					<< footprint
+					<< " B"
+					<< std::setw(5)
+					<< getCachePlacement(system_info, footprint)
+					<< std::setw(10)
+					<< std::fixed
+					<< std::setprecision(2)
+					<< static_cast<double>(timer.getNSecs()) / static_cast<double>(std::max(1ull, pixels))
+					<< " ns/pixel"
+					<< std::endl;
+			}
+		}
+	}
+	catch (...) {
+		destroyClutMethods(clut_methods);
+		throw;
+	}
+
+	destroyClutMethods(clut_methods);
+}
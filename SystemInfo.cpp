@@ -0,0 +1,129 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <fstream>
+#include <sstream>
+
+#include "SystemInfo.hpp"
+
+namespace
+{
+
+	bool readLine(const std::string& path, std::string& line)
+	{
+		std::ifstream file(path.c_str());
+		std::getline(file, line);
+		return !file.fail();
+	}
+
+	size_t parseSize(const std::string& string)
+	{
+		std::istringstream stream(string);
+		size_t size = 0;
+		char unit = 0;
+		stream >> size >> unit;
+		switch (unit) {
+			case 'K': {
+				return size << 10;
+			}
+			case 'M': {
+				return size << 20;
+			}
+			case 'G': {
+				return size << 30;
+			}
+		}
+		return size;
+	}
+
+}
+
+SystemInfo::SystemInfo() :
+	available_memory(0)
+{
+	for (unsigned int level = 0; level < 4; ++level) {
+		cache_sizes[level] = 0;
+	}
+
+	for (unsigned int index = 0; ; ++index) {
+		std::ostringstream base;
+		base << "/sys/devices/system/cpu/cpu0/cache/index" << index << '/';
+
+		std::string level_string;
+		std::string type;
+		std::string size;
+		if (
+			!readLine(base.str() + "level", level_string)
+			|| !readLine(base.str() + "type", type)
+			|| !readLine(base.str() + "size", size)
+		) {
+			break;
+		}
+
+		unsigned int level = 0;
+		std::istringstream(level_string) >> level;
+		if (level > 0 && level < 4 && type != "Instruction") {
+			cache_sizes[level] = parseSize(size);
+		}
+	}
+
+	std::ifstream meminfo("/proc/meminfo");
+	std::string line;
+	while (std::getline(meminfo, line)) {
+		if (line.compare(0, 13, "MemAvailable:") == 0) {
+			std::istringstream stream(line.substr(13));
+			size_t kib = 0;
+			stream >> kib;
+			available_memory = kib << 10;
+			break;
+		}
+	}
+
+	std::ifstream cpuinfo("/proc/cpuinfo");
+	while (std::getline(cpuinfo, line)) {
+		if (line.compare(0, 10, "model name") == 0) {
+			const std::string::size_type value = line.find_first_not_of(" \t:", 10);
+			if (value != std::string::npos) {
+				cpu_model = line.substr(value);
+			}
+			break;
+		}
+	}
+}
+
+size_t SystemInfo::getCacheSize(unsigned int level) const
+{
+	if (level > 0 && level < 4) {
+		return cache_sizes[level];
+	}
+	return 0;
+}
+
+size_t SystemInfo::getAvailableMemory() const
+{
+	return available_memory;
+}
+
+const std::string& SystemInfo::getCpuModel() const
+{
+	return cpu_model;
+}
@@ -0,0 +1,46 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+class SystemInfo
+{
+public:
+	SystemInfo();
+
+	// Size in bytes of the data (or unified) cache of the given level, 0 if unknown
+	size_t getCacheSize(unsigned int level) const;
+
+	// MemAvailable from /proc/meminfo at construction in bytes, 0 if unknown
+	size_t getAvailableMemory() const;
+
+	// "model name" from /proc/cpuinfo, empty if unknown
+	const std::string& getCpuModel() const;
+
+private:
+	size_t cache_sizes[4];
+	size_t available_memory;
+	std::string cpu_model;
+};
@@ -20,36 +20,70 @@
  * 
  */
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #include "TestBench.hpp"
 
+#include "ClutFile.hpp"
 #include "ClutMethod.hpp"
 #include "Timer.hpp"
 #include "Exception.hpp"
+#include "HaldClut.hpp"
+#include "Memory.hpp"
+
+namespace
+{
+
+	struct Position {
+		unsigned int x;
+		unsigned int y;
+	};
+
+	// Per axis, so there are at most 32768 buckets
+	const unsigned int max_bucket_count = 32;
+
+	inline unsigned int getBucket(float value, unsigned int bucket_count)
+	{
+		return std::min(bucket_count - 1, static_cast<unsigned int>(value * bucket_count / 65536.0f));
+	}
+
+}
 
 TestBench::TestBench(const Image& _input_image, const Image& _clut_image) :
 	input_image(_input_image),
-	clut_image(_clut_image),
-	clut_level(0)
+	clut_image(&_clut_image),
+	clut_file(0),
+	clut_level(getHaldClutLevel(_clut_image))
 {
-	if (clut_image.getWidth() == clut_image.getHeight()) {
-		unsigned int level = 1;
-		while (level * level * level < clut_image.getWidth()) {
-			++level;
-		}
-		if (level * level * level == clut_image.getWidth()) {
-			clut_level = level;
-		}
-	}
 	if (clut_level < 2) {
 		throw Exception("CLUT image has wrong dimensions.", __FILE__, __LINE__);
 	}
 
 	output_image.clearAndInitialize(input_image.getWidth(), input_image.getHeight());
+	output_image.copyAlpha(input_image);
+	setup_timer.stop();
+}
+
+TestBench::TestBench(const Image& _input_image, const ClutFile& _clut_file) :
+	input_image(_input_image),
+	clut_image(0),
+	clut_file(&_clut_file),
+	clut_level(_clut_file.getLevel())
+{
+	if (clut_level < 2) {
+		throw Exception("CLUT file not loaded.", __FILE__, __LINE__);
+	}
+
+	output_image.clearAndInitialize(input_image.getWidth(), input_image.getHeight());
+	output_image.copyAlpha(input_image);
+	setup_timer.stop();
 }
 
 Timer TestBench::run(ClutMethod* clut_method, unsigned int cycles)
 {
-	clut_method->setClut(clut_image, clut_level);
+	setClut(clut_method);
 
 	Timer timer;
 	for (unsigned int cycle = 0; cycle < cycles; ++cycle) {
@@ -59,6 +93,7 @@ Timer TestBench::run(ClutMethod* clut_method, unsigned int cycles)
 				rgb[0] = input_image.getR(x, y);
 				rgb[1] = input_image.getG(x, y);
 				rgb[2] = input_image.getB(x, y);
+				rgb[3] = 0.0f;
 				clut_method->convert(rgb);
 				output_image.setR(x, y, rgb[0]);
 				output_image.setG(x, y, rgb[1]);
@@ -71,7 +106,148 @@ Timer TestBench::run(ClutMethod* clut_method, unsigned int cycles)
 	return timer;
 }
 
+Timer TestBench::runRows(ClutMethod* clut_method, unsigned int cycles)
+{
+	setClut(clut_method);
+
+	float* const row = reinterpret_cast<float*>(allocateMemory(static_cast<size_t>(input_image.getWidth()) * 4 * sizeof(float), 4 * sizeof(float)));
+
+	Timer timer;
+	for (unsigned int cycle = 0; cycle < cycles; ++cycle) {
+		for (unsigned int y = 0; y < input_image.getHeight(); ++y) {
+			for (unsigned int x = 0; x < input_image.getWidth(); ++x) {
+				row[x * 4] = input_image.getR(x, y);
+				row[x * 4 + 1] = input_image.getG(x, y);
+				row[x * 4 + 2] = input_image.getB(x, y);
+				row[x * 4 + 3] = 0.0f;
+			}
+			clut_method->convertRow(row, input_image.getWidth());
+			for (unsigned int x = 0; x < input_image.getWidth(); ++x) {
+				output_image.setR(x, y, row[x * 4]);
+				output_image.setG(x, y, row[x * 4 + 1]);
+				output_image.setB(x, y, row[x * 4 + 2]);
+			}
+		}
+	}
+	timer.stop();
+
+	freeMemory(row);
+
+	return timer;
+}
+
+TestBench::SortedTimes TestBench::runSorted(ClutMethod* clut_method, unsigned int cycles)
+{
+	setClut(clut_method);
+
+	const unsigned int bucket_count = std::min(max_bucket_count, clut_level * clut_level - 1);
+	const size_t size = static_cast<size_t>(input_image.getWidth()) * input_image.getHeight();
+
+	std::vector<unsigned int> buckets(size);
+	// Pixel counts, then positions, so they can pass 4 G
+	std::vector<size_t> offsets(bucket_count * bucket_count * bucket_count + 1);
+	std::vector<Position> order(size);
+
+	SortedTimes res = {
+		0,
+		0
+	};
+
+	for (unsigned int cycle = 0; cycle < cycles; ++cycle) {
+		Timer sort_timer;
+
+		std::fill(offsets.begin(), offsets.end(), 0);
+
+		size_t index = 0;
+		for (unsigned int y = 0; y < input_image.getHeight(); ++y) {
+			for (unsigned int x = 0; x < input_image.getWidth(); ++x) {
+				// Red varies fastest in the CLUT, so it does in the bucket index
+				const unsigned int bucket =
+					getBucket(input_image.getR(x, y), bucket_count)
+					+ getBucket(input_image.getG(x, y), bucket_count) * bucket_count
+					+ getBucket(input_image.getB(x, y), bucket_count) * bucket_count * bucket_count;
+				buckets[index] = bucket;
+				++offsets[bucket + 1];
+				++index;
+			}
+		}
+
+		for (std::vector<size_t>::size_type bucket = 1; bucket < offsets.size(); ++bucket) {
+			offsets[bucket] += offsets[bucket - 1];
+		}
+
+		index = 0;
+		for (unsigned int y = 0; y < input_image.getHeight(); ++y) {
+			for (unsigned int x = 0; x < input_image.getWidth(); ++x) {
+				Position& position = order[offsets[buckets[index]]++];
+				position.x = x;
+				position.y = y;
+				++index;
+			}
+		}
+
+		sort_timer.stop();
+		res.sort_nsecs += sort_timer.getNSecs();
+
+		Timer convert_timer;
+
+		for (std::vector<Position>::const_iterator order_it = order.begin(); order_it != order.end(); ++order_it) {
+			float rgb[4] __attribute__((aligned(16)));
+			rgb[0] = input_image.getR(order_it->x, order_it->y);
+			rgb[1] = input_image.getG(order_it->x, order_it->y);
+			rgb[2] = input_image.getB(order_it->x, order_it->y);
+			rgb[3] = 0.0f;
+			clut_method->convert(rgb);
+			output_image.setR(order_it->x, order_it->y, rgb[0]);
+			output_image.setG(order_it->x, order_it->y, rgb[1]);
+			output_image.setB(order_it->x, order_it->y, rgb[2]);
+		}
+
+		convert_timer.stop();
+		res.convert_nsecs += convert_timer.getNSecs();
+	}
+
+	return res;
+}
+
+unsigned int TestBench::getClutLevel() const
+{
+	return clut_level;
+}
+
 const Image& TestBench::getOutputImage() const
 {
 	return output_image;
 }
+
+Image TestBench::takeOutputImage()
+{
+	Image res(std::move(output_image));
+	output_image.clearAndInitialize(input_image.getWidth(), input_image.getHeight());
+	output_image.copyAlpha(input_image);
+	return res;
+}
+
+const Timer& TestBench::getSetupTimer() const
+{
+	return setup_timer;
+}
+
+void TestBench::setClut(ClutMethod* clut_method)
+{
+	setup_timer.start();
+	const bool packed = clut_file && clut_method->setPackedClut(clut_file->getData(), clut_level);
+	setup_timer.stop();
+
+	if (!packed) {
+		if (!clut_image) {
+			// Unpacked once for all methods without packed storage
+			clut_file->unpack(unpacked_clut_image);
+			clut_image = &unpacked_clut_image;
+		}
+
+		setup_timer.start();
+		clut_method->setClut(*clut_image, clut_level);
+		setup_timer.stop();
+	}
+}
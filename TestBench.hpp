@@ -23,23 +23,45 @@
 #pragma once
 
 #include "Image.hpp"
+#include "Timer.hpp"
 
+class ClutFile;
 class ClutMethod;
-class Timer;
 
 class TestBench
 {
 public:
+	struct SortedTimes {
+		unsigned long long sort_nsecs;
+		unsigned long long convert_nsecs;
+	};
+
 	TestBench(const Image& _input_image, const Image& _clut_image);
+	// Methods supporting packed storage use the CLUT file directly
+	TestBench(const Image& _input_image, const ClutFile& _clut_file);
 
 	Timer run(ClutMethod* clut_method, unsigned int cycles);
+	// Gathers each row into a buffer and converts it with ClutMethod::convertRow()
+	Timer runRows(ClutMethod* clut_method, unsigned int cycles);
+	// Bins the pixels by CLUT region with a counting sort and converts them bucket by bucket
+	SortedTimes runSorted(ClutMethod* clut_method, unsigned int cycles);
 
+	unsigned int getClutLevel() const;
 	const Image& getOutputImage() const;
+	// Moves the output out instead of copying it, the next run gets fresh planes
+	Image takeOutputImage();
+	// Time spent in setClut() or setPackedClut() by the last run
+	const Timer& getSetupTimer() const;
 
 private:
+	void setClut(ClutMethod* clut_method);
+
 	const Image& input_image;
-	const Image& clut_image;
+	const Image* clut_image;
+	const ClutFile* const clut_file;
 
 	unsigned int clut_level;
+	Image unpacked_clut_image;
 	Image output_image;
+	Timer setup_timer;
 };
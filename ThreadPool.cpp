@@ -0,0 +1,146 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+
+#include <unistd.h>
+
+#include "ThreadPool.hpp"
+
+#include "Exception.hpp"
+
+ThreadPool::ThreadPool(unsigned int thread_count, unsigned int _max_queued) :
+	max_queued(std::max(1u, _max_queued)),
+	running(0),
+	stopping(false)
+{
+	pthread_mutex_init(&mutex, 0);
+	pthread_cond_init(&job_available, 0);
+	pthread_cond_init(&slot_available, 0);
+	pthread_cond_init(&jobs_done, 0);
+
+	for (unsigned int thread = 0; thread < std::max(1u, thread_count); ++thread) {
+		pthread_t id;
+		if (pthread_create(&id, 0, work, this)) {
+			break;
+		}
+		threads.push_back(id);
+	}
+
+	if (threads.empty()) {
+		pthread_cond_destroy(&jobs_done);
+		pthread_cond_destroy(&slot_available);
+		pthread_cond_destroy(&job_available);
+		pthread_mutex_destroy(&mutex);
+		throw Exception("Can't create worker threads.", __FILE__, __LINE__);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	wait();
+
+	pthread_mutex_lock(&mutex);
+	stopping = true;
+	pthread_cond_broadcast(&job_available);
+	pthread_mutex_unlock(&mutex);
+
+	for (std::vector<pthread_t>::const_iterator threads_it = threads.begin(); threads_it != threads.end(); ++threads_it) {
+		pthread_join(*threads_it, 0);
+	}
+
+	pthread_cond_destroy(&jobs_done);
+	pthread_cond_destroy(&slot_available);
+	pthread_cond_destroy(&job_available);
+	pthread_mutex_destroy(&mutex);
+}
+
+void ThreadPool::submit(Job* job)
+{
+	pthread_mutex_lock(&mutex);
+	while (jobs.size() >= max_queued) {
+		pthread_cond_wait(&slot_available, &mutex);
+	}
+	try {
+		jobs.push_back(job);
+	}
+	catch (...) {
+		pthread_mutex_unlock(&mutex);
+		delete job;
+		throw;
+	}
+	pthread_cond_signal(&job_available);
+	pthread_mutex_unlock(&mutex);
+}
+
+void ThreadPool::wait()
+{
+	pthread_mutex_lock(&mutex);
+	while (!jobs.empty() || running) {
+		pthread_cond_wait(&jobs_done, &mutex);
+	}
+	pthread_mutex_unlock(&mutex);
+}
+
+unsigned int ThreadPool::getThreadCount() const
+{
+	return threads.size();
+}
+
+unsigned int ThreadPool::getDefaultThreadCount()
+{
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? count : 1;
+}
+
+void* ThreadPool::work(void* data)
+{
+	ThreadPool* const pool = static_cast<ThreadPool*>(data);
+
+	pthread_mutex_lock(&pool->mutex);
+	for (;;) {
+		while (pool->jobs.empty() && !pool->stopping) {
+			pthread_cond_wait(&pool->job_available, &pool->mutex);
+		}
+		if (pool->jobs.empty()) {
+			break;
+		}
+
+		Job* const job = pool->jobs.front();
+		pool->jobs.pop_front();
+		++pool->running;
+		pthread_cond_signal(&pool->slot_available);
+		pthread_mutex_unlock(&pool->mutex);
+
+		job->run();
+		delete job;
+
+		pthread_mutex_lock(&pool->mutex);
+		--pool->running;
+		if (pool->jobs.empty() && !pool->running) {
+			pthread_cond_broadcast(&pool->jobs_done);
+		}
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	return 0;
+}
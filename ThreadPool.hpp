@@ -0,0 +1,75 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include <pthread.h>
+
+class ThreadPool
+{
+public:
+	class Job
+	{
+	public:
+		virtual ~Job()
+		{
+		}
+
+		// Must not throw
+		virtual void run() = 0;
+	};
+
+	// Submitting blocks while max_queued jobs are waiting
+	ThreadPool(unsigned int thread_count, unsigned int _max_queued);
+	~ThreadPool();
+
+	// Takes ownership of the job, also if submitting fails
+	void submit(Job* job);
+	// Returns when all submitted jobs are done
+	void wait();
+
+	unsigned int getThreadCount() const;
+
+	static unsigned int getDefaultThreadCount();
+
+private:
+	ThreadPool(const ThreadPool& other);
+	ThreadPool& operator =(const ThreadPool& other);
+
+	static void* work(void* data);
+
+	const unsigned int max_queued;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t job_available;
+	pthread_cond_t slot_available;
+	pthread_cond_t jobs_done;
+
+	std::deque<Job*> jobs;
+	unsigned int running;
+	bool stopping;
+
+	std::vector<pthread_t> threads;
+};
@@ -0,0 +1,288 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include <stdint.h>
+
+#include "TileCache.hpp"
+
+#include "ClutMethod.hpp"
+#include "Conversion.hpp"
+#include "Exception.hpp"
+#include "Image.hpp"
+#include "Memory.hpp"
+
+namespace
+{
+
+	const uint64_t hash_multiplier = 0x9E3779B97F4A7C15ULL;
+
+	inline uint64_t rotate(uint64_t value, unsigned int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	inline uint64_t mix(uint64_t hash, uint64_t value)
+	{
+		return rotate(hash ^ (value * hash_multiplier), 29) * hash_multiplier;
+	}
+
+	// Four independent lanes of eight bytes hide the multiply latency, so
+	// hashing stays much cheaper than converting the same samples
+	uint64_t hashBytes(const char* data, size_t size, uint64_t hash)
+	{
+		uint64_t lanes[4] = {hash, hash + 1, hash + 2, hash + 3};
+
+		size_t offset = 0;
+		for (; offset + 4 * sizeof(uint64_t) <= size; offset += 4 * sizeof(uint64_t)) {
+			uint64_t values[4];
+			std::memcpy(values, data + offset, sizeof(values));
+			lanes[0] = mix(lanes[0], values[0]);
+			lanes[1] = mix(lanes[1], values[1]);
+			lanes[2] = mix(lanes[2], values[2]);
+			lanes[3] = mix(lanes[3], values[3]);
+		}
+
+		hash = mix(mix(mix(lanes[0], lanes[1]), lanes[2]), lanes[3]);
+
+		for (; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t)) {
+			uint64_t value;
+			std::memcpy(&value, data + offset, sizeof(value));
+			hash = mix(hash, value);
+		}
+		for (; offset < size; ++offset) {
+			hash = mix(hash, static_cast<unsigned char>(data[offset]));
+		}
+		return hash;
+	}
+
+	uint64_t finalizeHash(uint64_t hash)
+	{
+		hash ^= hash >> 33;
+		hash *= 0xFF51AFD7ED558CCDULL;
+		hash ^= hash >> 33;
+		hash *= 0xC4CEB9FE1A85EC53ULL;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+}
+
+bool TileCache::Key::operator <(const Key& other) const
+{
+	if (hash != other.hash) {
+		return hash < other.hash;
+	}
+	if (clut_id != other.clut_id) {
+		return clut_id < other.clut_id;
+	}
+	if (strength != other.strength) {
+		return strength < other.strength;
+	}
+	if (width != other.width) {
+		return width < other.width;
+	}
+	return height < other.height;
+}
+
+TileCache::TileCache(unsigned int _tile_size, size_t _max_bytes) :
+	tile_size(_tile_size),
+	max_bytes(_max_bytes),
+	size(0),
+	last_output(0)
+{
+	if (tile_size < 4) {
+		throw Exception("Tile size must be at least 4.", __FILE__, __LINE__);
+	}
+}
+
+TileCache::~TileCache()
+{
+	clear();
+}
+
+TileCache::Statistics TileCache::apply(ClutMethod& clut_method, unsigned long long clut_id, float strength, const Image& input_image, Image& output_image)
+{
+	if (input_image.getPrecision() != Image::PRECISION_FLOAT) {
+		throw Exception("Tile cache needs float planes.", __FILE__, __LINE__);
+	}
+
+	const unsigned int width = input_image.getWidth();
+	const unsigned int height = input_image.getHeight();
+
+	const bool same_output =
+		&output_image == last_output
+		&& output_image.getWidth() == width
+		&& output_image.getHeight() == height
+		&& output_image.getPrecision() == Image::PRECISION_FLOAT;
+	std::vector<Key> keys;
+	if (same_output) {
+		keys.swap(last_keys);
+	}
+	last_output = 0;
+	last_keys.clear();
+
+	clut_method.setStrength(strength);
+	output_image.clearAndInitialize(width, height, false);
+	output_image.copyAlpha(input_image);
+
+	Statistics statistics = {0, 0, 0, 0, 0};
+	const size_t tiles_x = (width + tile_size - 1) / tile_size;
+	const size_t tiles_y = (height + tile_size - 1) / tile_size;
+	keys.resize(tiles_x * tiles_y);
+
+	float* const rgb = reinterpret_cast<float*>(allocateMemory(static_cast<size_t>(tile_size) * 4 * sizeof(float), 4 * sizeof(float)));
+
+	for (unsigned int tile_y = 0; tile_y < height; tile_y += tile_size) {
+		const unsigned int tile_height = std::min(tile_size, height - tile_y);
+
+		for (unsigned int tile_x = 0; tile_x < width; tile_x += tile_size) {
+			const unsigned int tile_width = std::min(tile_size, width - tile_x);
+			const size_t row_size = tile_width * sizeof(float);
+
+			uint64_t hash = tile_width * hash_multiplier + tile_height;
+			for (unsigned int y = tile_y; y < tile_y + tile_height; ++y) {
+				for (unsigned int channel = 0; channel < 3; ++channel) {
+					hash = hashBytes(static_cast<const char*>(input_image.getRow(channel, y)) + tile_x * sizeof(float), row_size, hash);
+				}
+			}
+
+			const Key key = {finalizeHash(hash), clut_id, strength, tile_width, tile_height};
+			Key& last_key = keys[tile_y / tile_size * tiles_x + tile_x / tile_size];
+			const bool unchanged = same_output && !(last_key < key) && !(key < last_key);
+			last_key = key;
+
+			++statistics.tiles;
+
+			Entries::iterator entry_it = entries.find(key);
+			if (unchanged) {
+				// Even if evicted meanwhile
+				if (entry_it != entries.end()) {
+					lru.splice(lru.begin(), lru, entry_it->second.lru_it);
+				}
+				++statistics.hits;
+				++statistics.unchanged;
+				continue;
+			}
+
+			if (entry_it != entries.end()) {
+				const float* data = entry_it->second.data;
+				for (unsigned int y = tile_y; y < tile_y + tile_height; ++y) {
+					for (unsigned int channel = 0; channel < 3; ++channel) {
+						std::memcpy(static_cast<float*>(output_image.getRow(channel, y)) + tile_x, data, row_size);
+						data += tile_width;
+					}
+				}
+
+				lru.splice(lru.begin(), lru, entry_it->second.lru_it);
+				++statistics.hits;
+				continue;
+			}
+
+			const size_t entry_size = row_size * 3 * tile_height;
+			Entry entry;
+			entry.data = reinterpret_cast<float*>(allocateMemory(entry_size, 4 * sizeof(float)));
+
+			float* data = entry.data;
+			for (unsigned int y = tile_y; y < tile_y + tile_height; ++y) {
+				loadFloatRow(
+					static_cast<const float*>(input_image.getRow(0, y)) + tile_x,
+					static_cast<const float*>(input_image.getRow(1, y)) + tile_x,
+					static_cast<const float*>(input_image.getRow(2, y)) + tile_x,
+					rgb,
+					tile_width
+				);
+				clut_method.convertRow(rgb, tile_width);
+				storeFloatRow(rgb, data, data + tile_width, data + 2 * tile_width, tile_width);
+
+				for (unsigned int channel = 0; channel < 3; ++channel) {
+					std::memcpy(static_cast<float*>(output_image.getRow(channel, y)) + tile_x, data, row_size);
+					data += tile_width;
+				}
+			}
+
+			lru.push_front(key);
+			entry.lru_it = lru.begin();
+			entries.insert(std::make_pair(key, entry));
+			size += entry_size;
+			++statistics.converted;
+
+			evict(statistics);
+		}
+	}
+
+	freeMemory(rgb);
+
+	last_output = &output_image;
+	last_keys.swap(keys);
+
+	return statistics;
+}
+
+void TileCache::clear()
+{
+	for (Entries::iterator entry_it = entries.begin(); entry_it != entries.end(); ++entry_it) {
+		freeMemory(entry_it->second.data);
+	}
+	entries.clear();
+	lru.clear();
+	size = 0;
+	last_output = 0;
+	last_keys.clear();
+}
+
+unsigned int TileCache::getTileSize() const
+{
+	return tile_size;
+}
+
+size_t TileCache::getSize() const
+{
+	return size;
+}
+
+unsigned long long TileCache::hashImage(const Image& image)
+{
+	const size_t row_size = static_cast<size_t>(image.getWidth()) * (image.getPrecision() == Image::PRECISION_FLOAT ? sizeof(float) : sizeof(unsigned short));
+
+	uint64_t hash = image.getWidth() * hash_multiplier + image.getHeight();
+	for (unsigned int y = 0; y < image.getHeight(); ++y) {
+		for (unsigned int channel = 0; channel < 3; ++channel) {
+			hash = hashBytes(static_cast<const char*>(image.getRow(channel, y)), row_size, hash);
+		}
+	}
+	return finalizeHash(hash);
+}
+
+void TileCache::evict(Statistics& statistics)
+{
+	while (size > max_bytes && lru.size() > 1) {
+		const Entries::iterator entry_it = entries.find(lru.back());
+		size -= static_cast<size_t>(entry_it->first.width) * entry_it->first.height * 3 * sizeof(float);
+		freeMemory(entry_it->second.data);
+		entries.erase(entry_it);
+		lru.pop_back();
+		++statistics.evicted;
+	}
+}
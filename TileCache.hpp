@@ -0,0 +1,104 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <vector>
+
+class ClutMethod;
+class Image;
+
+// Output cache for interactive re-application: the input is split into
+// square tiles, each tile is hashed and its converted output is kept under
+// (tile hash, CLUT id, strength). Only tiles without a cached output are
+// converted again, identical tiles elsewhere in the image are shared.
+// Least recently used tiles are evicted beyond the byte budget. Tiles the
+// output still holds from the previous call are not even copied, so the
+// output must not be modified in between.
+class TileCache
+{
+public:
+	struct Statistics {
+		size_t tiles;
+		size_t hits;
+		// Hits already in place in the output
+		size_t unchanged;
+		size_t converted;
+		size_t evicted;
+	};
+
+	explicit TileCache(unsigned int _tile_size = 64, size_t _max_bytes = 256 << 20);
+	~TileCache();
+
+	// Sets the strength on the method and converts the input, (re)initializing
+	// the output. The CLUT id must change whenever the method's CLUT does,
+	// see hashImage(). Float planes only.
+	Statistics apply(ClutMethod& clut_method, unsigned long long clut_id, float strength, const Image& input_image, Image& output_image);
+
+	void clear();
+
+	unsigned int getTileSize() const;
+	// Bytes of cached output
+	size_t getSize() const;
+
+	// Hash of the planes, suitable as CLUT id
+	static unsigned long long hashImage(const Image& image);
+
+private:
+	struct Key {
+		unsigned long long hash;
+		unsigned long long clut_id;
+		float strength;
+		unsigned int width;
+		unsigned int height;
+
+		bool operator <(const Key& other) const;
+	};
+
+	struct Entry {
+		// Planar per tile row: red, green and blue of width floats each
+		float* data;
+		std::list<Key>::iterator lru_it;
+	};
+
+	typedef std::map<Key, Entry> Entries;
+
+	TileCache(const TileCache& other);
+	TileCache& operator =(const TileCache& other);
+
+	void evict(Statistics& statistics);
+
+	const unsigned int tile_size;
+	const size_t max_bytes;
+
+	Entries entries;
+	// Most recently used first
+	std::list<Key> lru;
+	size_t size;
+
+	// Keys of the tiles last written to that output, row by row
+	const Image* last_output;
+	std::vector<Key> last_keys;
+};
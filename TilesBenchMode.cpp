@@ -0,0 +1,188 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <iostream>
+
+#include "TilesBenchMode.hpp"
+
+#include "Arguments.hpp"
+#include "Conversion.hpp"
+#include "Exception.hpp"
+#include "HaldClut.hpp"
+#include "Image.hpp"
+#include "ImageFormats.hpp"
+#include "SseClutMethod.hpp"
+#include "TileCache.hpp"
+#include "Timer.hpp"
+
+namespace
+{
+
+	// Brightens a disc like a dodge brush dab
+	void paintDab(Image& image, int center_x, int center_y, int radius)
+	{
+		for (int y = std::max(0, center_y - radius); y < std::min<int>(image.getHeight(), center_y + radius + 1); ++y) {
+			for (int x = std::max(0, center_x - radius); x < std::min<int>(image.getWidth(), center_x + radius + 1); ++x) {
+				if ((x - center_x) * (x - center_x) + (y - center_y) * (y - center_y) <= radius * radius) {
+					image.setR(x, y, image.getR(x, y) * 1.1f + 256.0f);
+					image.setG(x, y, image.getG(x, y) * 1.1f + 256.0f);
+					image.setB(x, y, image.getB(x, y) * 1.1f + 256.0f);
+				}
+			}
+		}
+	}
+
+	void printStatistics(const char* label, unsigned long long usecs, const TileCache::Statistics& statistics)
+	{
+		std::cout
+			<< label
+			<< static_cast<double>(usecs) / 1000.0
+			<< "ms ("
+			<< statistics.converted
+			<< " of "
+			<< statistics.tiles
+			<< " tiles converted, "
+			<< statistics.unchanged
+			<< " left in place)"
+			<< std::endl;
+	}
+
+}
+
+const char* TilesBenchMode::getName() const
+{
+	return "--tiles";
+}
+
+const char* TilesBenchMode::getUsage() const
+{
+	return "INPUT CLUT [EDITS] [BRUSH_RADIUS] [TILE_SIZE]";
+}
+
+unsigned int TilesBenchMode::getMinimumArgumentCount() const
+{
+	return 2;
+}
+
+void TilesBenchMode::run(const std::vector<std::string>& args)
+{
+	Image input_image;
+	loadImage(args[0], input_image);
+
+	Image clut_image;
+	loadImage(args[1], clut_image);
+
+	const unsigned int level = getHaldClutLevel(clut_image);
+	if (level < 2) {
+		throw Exception("CLUT image has wrong dimensions.", __FILE__, __LINE__);
+	}
+
+	unsigned int edits = 20;
+	if (args.size() > 2) {
+		edits = getNumber(args[2]);
+	}
+
+	unsigned int radius = 24;
+	if (args.size() > 3) {
+		radius = getNumber(args[3]);
+	}
+
+	unsigned int tile_size = 64;
+	if (args.size() > 4) {
+		tile_size = getNumber(args[4]);
+	}
+
+	SseClutMethod clut_method;
+	clut_method.setClut(clut_image, level);
+	const unsigned long long clut_id = TileCache::hashImage(clut_image);
+
+	TileCache tile_cache(tile_size);
+	Image full_image;
+	Image incremental_image;
+
+	Timer full_timer;
+	convertRows(clut_method, input_image, full_image);
+	full_timer.stop();
+
+	Timer cold_timer;
+	const TileCache::Statistics cold_statistics = tile_cache.apply(clut_method, clut_id, 1.0f, input_image, incremental_image);
+	cold_timer.stop();
+
+	std::cout << "Full:       " << static_cast<double>(full_timer.getUSecs()) / 1000.0 << "ms" << std::endl;
+	printStatistics("Cold cache: ", cold_timer.getUSecs(), cold_statistics);
+
+	// Dabs at deterministic pseudo random positions, each followed by a re-application
+	Image edited_image(input_image);
+	unsigned int seed = 1;
+	unsigned long long full_usecs = 0;
+	unsigned long long incremental_usecs = 0;
+	TileCache::Statistics edit_statistics = {0, 0, 0, 0, 0};
+	unsigned int max_difference = 0;
+
+	for (unsigned int edit = 0; edit < edits; ++edit) {
+		seed = seed * 1103515245 + 12345;
+		const int x = (seed >> 8) % input_image.getWidth();
+		seed = seed * 1103515245 + 12345;
+		const int y = (seed >> 8) % input_image.getHeight();
+		paintDab(edited_image, x, y, radius);
+
+		Timer edit_full_timer;
+		convertRows(clut_method, edited_image, full_image);
+		edit_full_timer.stop();
+		full_usecs += edit_full_timer.getUSecs();
+
+		Timer edit_incremental_timer;
+		const TileCache::Statistics statistics = tile_cache.apply(clut_method, clut_id, 1.0f, edited_image, incremental_image);
+		edit_incremental_timer.stop();
+		incremental_usecs += edit_incremental_timer.getUSecs();
+
+		edit_statistics.tiles += statistics.tiles;
+		edit_statistics.hits += statistics.hits;
+		edit_statistics.unchanged += statistics.unchanged;
+		edit_statistics.converted += statistics.converted;
+
+		const Image::Difference difference = full_image.compare(incremental_image);
+		max_difference = std::max(max_difference, std::max(difference.max_r, std::max(difference.max_g, difference.max_b)));
+	}
+
+	if (edits) {
+		std::cout << std::endl;
+		std::cout << "Full edit:  " << static_cast<double>(full_usecs) / 1000.0 / edits << "ms per edit" << std::endl;
+		printStatistics("Tile edit:  ", incremental_usecs / edits, edit_statistics);
+		std::cout << "Speedup:    " << static_cast<double>(full_usecs) / std::max(1ull, incremental_usecs) << std::endl;
+		std::cout << "Difference: " << max_difference << " max" << std::endl;
+	}
+
+	Timer undo_timer;
+	const TileCache::Statistics undo_statistics = tile_cache.apply(clut_method, clut_id, 1.0f, input_image, incremental_image);
+	undo_timer.stop();
+
+	Timer strength_timer;
+	const TileCache::Statistics strength_statistics = tile_cache.apply(clut_method, clut_id, 0.5f, input_image, incremental_image);
+	strength_timer.stop();
+
+	std::cout << std::endl;
+	printStatistics("Undo all:   ", undo_timer.getUSecs(), undo_statistics);
+	printStatistics("Strength:   ", strength_timer.getUSecs(), strength_statistics);
+	std::cout << "Cache:      " << tile_cache.getSize() / 1024 << " KiB" << std::endl;
+}
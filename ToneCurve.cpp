@@ -0,0 +1,119 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <istream>
+
+#include "ToneCurve.hpp"
+
+#include "Exception.hpp"
+#include "Image.hpp"
+
+namespace
+{
+
+	// 16KiB of samples, small enough for the L1 cache
+	const unsigned int default_sample_count = 4097;
+
+	float srgbEncode(float value)
+	{
+		return
+			value <= 0.0031308f
+				? value * 12.92f
+				: 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	float srgbDecode(float value)
+	{
+		return
+			value <= 0.04045f
+				? value / 12.92f
+				: std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	std::vector<float> sample(float (*function)(float))
+	{
+		std::vector<float> res(default_sample_count);
+		for (unsigned int index = 0; index < default_sample_count; ++index) {
+			res[index] = 65535.0f * function(static_cast<float>(index) / static_cast<float>(default_sample_count - 1));
+		}
+		return res;
+	}
+
+}
+
+ToneCurve::ToneCurve(const std::vector<float>& _samples) :
+	samples(_samples)
+{
+	if (samples.size() < 2) {
+		throw Exception("Tone curve needs at least two samples.", __FILE__, __LINE__);
+	}
+
+	// One more, so the interpolation at 65535 doesn't need a bounds check
+	samples.push_back(samples.back());
+	scale = static_cast<float>(_samples.size() - 1) / 65535.0f;
+}
+
+ToneCurve ToneCurve::createSrgbEncoding()
+{
+	return ToneCurve(sample(srgbEncode));
+}
+
+ToneCurve ToneCurve::createSrgbDecoding()
+{
+	return ToneCurve(sample(srgbDecode));
+}
+
+ToneCurve ToneCurve::load(std::istream& stream)
+{
+	std::vector<float> samples;
+	float value;
+	while (stream >> value) {
+		samples.push_back(std::max(0.0f, std::min(65535.0f, value)));
+	}
+	if (!stream.eof()) {
+		throw Exception("Malformed tone curve.", __FILE__, __LINE__);
+	}
+	return ToneCurve(samples);
+}
+
+void ToneCurve::apply(Image& image) const
+{
+	for (unsigned int y = 0; y < image.getHeight(); ++y) {
+		for (unsigned int x = 0; x < image.getWidth(); ++x) {
+			image.setR(x, y, apply(image.getR(x, y)));
+			image.setG(x, y, apply(image.getG(x, y)));
+			image.setB(x, y, apply(image.getB(x, y)));
+		}
+	}
+}
+
+const float* ToneCurve::getSamples() const
+{
+	return &samples[0];
+}
+
+float ToneCurve::getScale() const
+{
+	return scale;
+}
@@ -0,0 +1,63 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <iosfwd>
+#include <vector>
+
+class Image;
+
+// 1D LUT mapping 0.0 to 65535.0 onto itself, sampled equidistantly and
+// interpolated linearly
+class ToneCurve
+{
+public:
+	explicit ToneCurve(const std::vector<float>& _samples);
+
+	// Linear to sRGB gamma encoded (OETF)
+	static ToneCurve createSrgbEncoding();
+	// sRGB gamma encoded to linear (EOTF)
+	static ToneCurve createSrgbDecoding();
+	// Whitespace separated samples in the 0 to 65535 range
+	static ToneCurve load(std::istream& stream);
+
+	// Inline, so fused kernels interpolate exactly like the separate pass
+	float apply(float value) const;
+	void apply(Image& image) const;
+
+	const float* getSamples() const;
+	float getScale() const;
+
+private:
+	std::vector<float> samples;
+	float scale;
+};
+
+inline float ToneCurve::apply(float value) const
+{
+	const float position = std::max(0.0f, std::min(65535.0f, value)) * scale;
+	const unsigned int index = position;
+	const float fraction = position - index;
+	return samples[index] * (1 - fraction) + samples[index + 1] * fraction;
+}
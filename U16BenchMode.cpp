@@ -0,0 +1,162 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+
+#include "U16BenchMode.hpp"
+
+#include "Arguments.hpp"
+#include "ClutMethod.hpp"
+#include "Conversion.hpp"
+#include "Exception.hpp"
+#include "FixedPointClutMethod.hpp"
+#include "HaldClut.hpp"
+#include "Image.hpp"
+#include "PpmImageReader.hpp"
+#include "PpmImageWriter.hpp"
+#include "SseClutMethod.hpp"
+#include "Timer.hpp"
+
+namespace
+{
+
+	struct PathTimes {
+		unsigned long long load_nsecs;
+		unsigned long long convert_nsecs;
+		unsigned long long save_nsecs;
+	};
+
+	PathTimes runPath(const std::string& input_path, const std::string& output_path, Image::Precision precision, const ClutMethod& clut_method, unsigned int cycles, Image& output_image)
+	{
+		Timer load_timer;
+		std::ifstream input_file(input_path.c_str());
+		Image input_image;
+		PpmImageReader(precision).load(input_file, input_image);
+		load_timer.stop();
+
+		Timer convert_timer;
+		for (unsigned int cycle = 0; cycle < cycles; ++cycle) {
+			convertRows(clut_method, input_image, output_image);
+		}
+		convert_timer.stop();
+
+		Timer save_timer;
+		std::ofstream output_file(output_path.c_str());
+		PpmImageWriter().save(output_image, output_file);
+		output_file.close();
+		save_timer.stop();
+
+		const PathTimes res = {
+			load_timer.getNSecs(),
+			convert_timer.getNSecs() / cycles,
+			save_timer.getNSecs()
+		};
+		return res;
+	}
+
+	void printPath(const char* label, const PathTimes& times)
+	{
+		std::cout
+			<< label
+			<< "load "
+			<< times.load_nsecs / 1000000
+			<< "ms, convert "
+			<< times.convert_nsecs / 1000000
+			<< "ms, save "
+			<< times.save_nsecs / 1000000
+			<< "ms, total "
+			<< (times.load_nsecs + times.convert_nsecs + times.save_nsecs) / 1000000
+			<< "ms"
+			<< std::endl;
+	}
+
+}
+
+const char* U16BenchMode::getName() const
+{
+	return "--u16";
+}
+
+const char* U16BenchMode::getUsage() const
+{
+	return "INPUT CLUT OUTPUT_PREFIX [CYCLES]";
+}
+
+unsigned int U16BenchMode::getMinimumArgumentCount() const
+{
+	return 3;
+}
+
+void U16BenchMode::run(const std::vector<std::string>& args)
+{
+	std::ifstream clut_file(args[1].c_str());
+	Image clut_image;
+	PpmImageReader().load(clut_file, clut_image);
+
+	const unsigned int level = getHaldClutLevel(clut_image);
+	if (level < 2) {
+		throw Exception("CLUT image has wrong dimensions.", __FILE__, __LINE__);
+	}
+
+	unsigned int cycles = 10;
+	if (args.size() > 3) {
+		cycles = std::max(1u, getNumber(args[3]));
+	}
+
+	SseClutMethod float_clut_method;
+	float_clut_method.setClut(clut_image, level);
+	FixedPointClutMethod u16_clut_method;
+	u16_clut_method.setClut(clut_image, level);
+
+	Image float_output_image;
+	const PathTimes float_times = runPath(args[0], args[2] + "_float.ppm", Image::PRECISION_FLOAT, float_clut_method, cycles, float_output_image);
+	Image u16_output_image;
+	const PathTimes u16_times = runPath(args[0], args[2] + "_u16.ppm", Image::PRECISION_U16, u16_clut_method, cycles, u16_output_image);
+
+	const unsigned long long float_total = float_times.load_nsecs + float_times.convert_nsecs + float_times.save_nsecs;
+	const unsigned long long u16_total = u16_times.load_nsecs + u16_times.convert_nsecs + u16_times.save_nsecs;
+
+	printPath("Float:      ", float_times);
+	printPath("16b:        ", u16_times);
+	std::cout
+		<< "Speedup:    "
+		<< static_cast<float>(float_times.convert_nsecs) / static_cast<float>(std::max(1ull, u16_times.convert_nsecs))
+		<< " convert, "
+		<< static_cast<float>(float_total) / static_cast<float>(std::max(1ull, u16_total))
+		<< " total"
+		<< std::endl;
+
+	const Image::Difference difference = float_output_image.compare(u16_output_image);
+	std::cout
+		<< "Difference: "
+		<< difference.absolute
+		<< " (Rmax "
+		<< difference.max_r
+		<< ", Gmax "
+		<< difference.max_g
+		<< ", Bmax "
+		<< difference.max_b
+		<< ')'
+		<< std::endl;
+}
@@ -0,0 +1,90 @@
+/*
+ * This file is part of clutbench.
+ *
+ * Copyright (c) 2014 Flössie <floessie.mail@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ */
+
+#ifndef CLUT_H
+#define CLUT_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* C interface of libclut: HaldCLUTs applied to caller owned pixel buffers */
+
+typedef struct clut clut_t;
+
+typedef enum {
+	CLUT_OK = 0,
+	CLUT_ERROR_ARGUMENT,
+	CLUT_ERROR_FORMAT,
+	CLUT_ERROR_MEMORY,
+	CLUT_ERROR_INTERNAL
+} clut_status;
+
+/* Interleaved samples, alpha is passed through untouched, floats range from 0 to 1 */
+typedef enum {
+	CLUT_PIXEL_RGB8 = 0,
+	CLUT_PIXEL_RGBA8,
+	CLUT_PIXEL_RGB16,
+	CLUT_PIXEL_RGBA16,
+	CLUT_PIXEL_RGB32F,
+	CLUT_PIXEL_RGBA32F
+} clut_pixel_format;
+
+/* HaldCLUT image in memory, as P6 (PPM), P7 (PAM) or PF (PFM) */
+clut_status clut_create_from_memory(const void* data, size_t size, clut_t** clut);
+/* HaldCLUT image as raw pixels, stride in bytes */
+clut_status clut_create_from_pixels(const void* pixels, unsigned int width, unsigned int height, size_t stride, clut_pixel_format format, clut_t** clut);
+void clut_destroy(clut_t* clut);
+
+unsigned int clut_get_level(const clut_t* clut);
+
+/* Kernels safe to run on several threads at once */
+unsigned int clut_get_kernel_count(void);
+const char* clut_get_kernel_name(unsigned int index);
+/*
+ * Fastest kernel without measurable loss for the format and the CLUT's level,
+ * measured on first use and remembered per machine in the kernel choices file
+ * of clutbench --select. NULL if the measurement fails.
+ */
+const char* clut_get_best_kernel(const clut_t* clut, clut_pixel_format format);
+const char* clut_get_kernel(const clut_t* clut);
+/* NULL selects the best kernel for float pixels, clut_create_*() start with "sse" */
+clut_status clut_set_kernel(clut_t* clut, const char* name);
+/* Blends the result with the input: out = in + strength * (lut - in) */
+clut_status clut_set_strength(clut_t* clut, float strength);
+
+/*
+ * Converts width x height pixels, strides in bytes. Source and destination
+ * may be the same buffer. 0 threads uses all cores, 1 only the calling
+ * thread. A handle must not be used by several threads at once.
+ */
+clut_status clut_apply(clut_t* clut, const void* source, size_t source_stride, void* destination, size_t destination_stride, unsigned int width, unsigned int height, clut_pixel_format format, unsigned int threads);
+
+const char* clut_get_status_message(clut_status status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif